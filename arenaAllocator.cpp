@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include "arenaAllocator.h"
+
+namespace
+{
+const size_t alignment_ = 64;
+const size_t hugePageSize_ = 2 * 1024 * 1024;
+
+enum class t_blockKind { heap, mapped };
+
+struct Block
+{
+    size_t size_;           // size class, what was really allocated
+    t_blockKind kind_;
+};
+
+// Only the pooling modes track their blocks. aligned mode allocates the exact
+// size with no lock; tracked_ counts pooled blocks still out, so a free in
+// aligned mode only looks them up while some remain.
+struct Arena
+{
+    std::mutex mutex_;
+    std::atomic<t_arenaMode> mode_{ t_arenaMode::aligned };
+    std::atomic<size_t> tracked_{ 0 };
+    std::unordered_map<void*, Block> blocks_;
+    std::map<size_t, std::vector<void*>> free_;
+};
+
+// Never destroyed, so vectors at namespace scope can still free at exit
+Arena& getArena()
+{
+    static Arena* arena = new Arena;
+    return( *arena );
+}
+
+// Powers of two below the huge page size, whole huge pages above
+size_t getSizeClass( size_t bytes )
+{
+    if( bytes >= hugePageSize_ )
+        return( (bytes + hugePageSize_ - 1) & ~(hugePageSize_ - 1) );
+
+    size_t size = alignment_;
+    while( size < bytes )
+    {
+        size *= 2;
+    }
+    return( size );
+}
+
+void* allocateHeap( size_t size )
+{
+#ifdef _MSC_VER
+    return( _aligned_malloc( size, alignment_ ) );
+#else
+    return( ::aligned_alloc( alignment_, size ) );
+#endif
+}
+
+void freeHeap( void* pointer )
+{
+#ifdef _MSC_VER
+    _aligned_free( pointer );
+#else
+    std::free( pointer );
+#endif
+}
+
+#ifdef __linux__
+// Huge page aligned mapping, the slack around it is unmapped again
+void* mapTransparentHuge( size_t size )
+{
+    void* mapping = mmap( nullptr, size + hugePageSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if( mapping == MAP_FAILED )
+        return( nullptr );
+
+    uintptr_t begin = reinterpret_cast<uintptr_t>( mapping );
+    uintptr_t aligned = (begin + hugePageSize_ - 1) & ~(hugePageSize_ - 1);
+    if( aligned > begin )
+        munmap( mapping, aligned - begin );
+    if( aligned + size < begin + size + hugePageSize_ )
+        munmap( reinterpret_cast<void*>( aligned + size ), begin + hugePageSize_ - aligned );
+
+    madvise( reinterpret_cast<void*>( aligned ), size, MADV_HUGEPAGE );
+    return( reinterpret_cast<void*>( aligned ) );
+}
+
+void* mapExplicitHuge( size_t size )
+{
+    void* mapping = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+    return( mapping == MAP_FAILED ? nullptr : mapping );
+}
+#endif
+
+void releaseBlock( void* pointer, const Block& block )
+{
+#ifdef __linux__
+    if( block.kind_ == t_blockKind::mapped )
+    {
+        munmap( pointer, block.size_ );
+        return;
+    }
+#endif
+    freeHeap( pointer );
+}
+} // namespace
+
+void setArenaMode( t_arenaMode mode )
+{
+    releaseArena();
+    std::lock_guard<std::mutex> lock( getArena().mutex_ );
+    getArena().mode_ = mode;
+}
+
+t_arenaMode getArenaMode()
+{
+    return( getArena().mode_ );
+}
+
+const char* getArenaModeName( t_arenaMode mode )
+{
+    switch( mode )
+    {
+    case t_arenaMode::aligned:          return( "aligned" );
+    case t_arenaMode::pool:             return( "pool" );
+    case t_arenaMode::transparentHuge:  return( "thp" );
+    case t_arenaMode::explicitHuge:     return( "hugetlb" );
+    default:                            return( "" );
+    }
+}
+
+void* arenaAllocate( size_t bytes )
+{
+    Arena& arena = getArena();
+    if( arena.mode_ == t_arenaMode::aligned )
+    {
+        void* pointer = allocateHeap( (std::max<size_t>( bytes, 1 ) + alignment_ - 1) & ~(alignment_ - 1) );
+        if( !pointer )
+            throw std::bad_alloc();
+        return( pointer );
+    }
+
+    size_t size = getSizeClass( bytes );
+    std::lock_guard<std::mutex> lock( arena.mutex_ );
+
+    auto cached = arena.free_.find( size );
+    if( cached != arena.free_.end() && !cached->second.empty() )
+    {
+        void* pointer = cached->second.back();
+        cached->second.pop_back();
+        return( pointer );
+    }
+
+    void* pointer = nullptr;
+    Block block{ size, t_blockKind::heap };
+#ifdef __linux__
+    if( size >= hugePageSize_ && arena.mode_ == t_arenaMode::explicitHuge )
+    {
+        pointer = mapExplicitHuge( size );
+        block.kind_ = t_blockKind::mapped;
+    }
+    if( !pointer && size >= hugePageSize_ && (arena.mode_ == t_arenaMode::transparentHuge || arena.mode_ == t_arenaMode::explicitHuge) )
+    {
+        pointer = mapTransparentHuge( size );
+        block.kind_ = t_blockKind::mapped;
+    }
+#endif
+    if( !pointer )
+    {
+        pointer = allocateHeap( size );
+        block.kind_ = t_blockKind::heap;
+    }
+    if( !pointer )
+        throw std::bad_alloc();
+
+    arena.blocks_.emplace( pointer, block );
+    ++arena.tracked_;
+    return( pointer );
+}
+
+void arenaFree( void* pointer, size_t )
+{
+    if( !pointer )
+        return;
+
+    Arena& arena = getArena();
+    if( arena.mode_ == t_arenaMode::aligned && arena.tracked_ == 0 )
+    {
+        freeHeap( pointer );
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock( arena.mutex_ );
+    auto found = arena.blocks_.find( pointer );
+    if( found == arena.blocks_.end() )
+    {
+        // From aligned mode, before a switch to a pooling one
+        freeHeap( pointer );
+        return;
+    }
+    if( arena.mode_ != t_arenaMode::aligned )
+    {
+        arena.free_[ found->second.size_ ].push_back( pointer );
+        return;
+    }
+
+    releaseBlock( pointer, found->second );
+    arena.blocks_.erase( found );
+    --arena.tracked_;
+}
+
+void releaseArena()
+{
+    Arena& arena = getArena();
+    std::lock_guard<std::mutex> lock( arena.mutex_ );
+    for( auto& sizeClass : arena.free_ )
+    {
+        for( void* pointer : sizeClass.second )
+        {
+            auto found = arena.blocks_.find( pointer );
+            releaseBlock( pointer, found->second );
+            arena.blocks_.erase( found );
+            --arena.tracked_;
+        }
+    }
+    arena.free_.clear();
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#ifndef __ARENA_ALLOCATOR__
+#define __ARENA_ALLOCATOR__
+
+#include <cstddef>
+#include <new>
+
+// Where matrix buffers come from
+//  aligned          every allocation goes to the system at its own size, as
+//                   boost::simd::allocator, with no lock or bookkeeping
+//  pool             freed blocks are kept per size class and reused by the next solve
+//  transparentHuge  pool, blocks of 2 MB and more are 2 MB aligned and madvise'd for THP
+//  explicitHuge     pool, blocks of 2 MB and more come from hugetlbfs (MAP_HUGETLB),
+//                   falling back to transparent huge pages when none are reserved
+enum class t_arenaMode { aligned, pool, transparentHuge, explicitHuge };
+
+void setArenaMode( t_arenaMode mode );
+t_arenaMode getArenaMode();
+const char* getArenaModeName( t_arenaMode mode );
+
+// Cache line and widest pack aligned, thread safe
+void* arenaAllocate( size_t bytes );
+void arenaFree( void* pointer, size_t bytes );
+
+// Returns every cached block to the system
+void releaseArena();
+
+template< typename T >
+struct ArenaAllocator
+{
+    using value_type = T;
+
+    ArenaAllocator() = default;
+    template< typename U > ArenaAllocator( const ArenaAllocator<U>& ) {}
+
+    T* allocate( size_t count ) { return( static_cast<T*>( arenaAllocate( count * sizeof( T ) ) ) ); }
+    void deallocate( T* pointer, size_t count ) { arenaFree( pointer, count * sizeof( T ) ); }
+};
+
+template< typename T, typename U >
+bool operator==( const ArenaAllocator<T>&, const ArenaAllocator<U>& ) { return( true ); }
+
+template< typename T, typename U >
+bool operator!=( const ArenaAllocator<T>&, const ArenaAllocator<U>& ) { return( false ); }
+
+#endif // __ARENA_ALLOCATOR__
@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif // __linux__
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif // _OPENMP
+
+#include "autoTune.h"
+#include "cpuDispatch.h"
+
+namespace
+{
+using t_tunedKernel = void (*)( t_dataVector& matrix, t_dataVector& factor, size_t parameter );
+
+void runSimd( t_dataVector& matrix, t_dataVector& factor, size_t ) { simdTransform( matrix, factor ); }
+void runUnrolledSimd( t_dataVector& matrix, t_dataVector& factor, size_t ) { unrolledSimdTransform( matrix, factor ); }
+void runFixedSimd( t_dataVector& matrix, t_dataVector& factor, size_t ) { fixedSimdTransform( matrix, factor ); }
+void runBlockedSimd( t_dataVector& matrix, t_dataVector& factor, size_t blockSize ) { blockedSimdTransform( matrix, factor, blockSize ); }
+void runDispatchSimd( t_dataVector& matrix, t_dataVector& factor, size_t ) { dispatchSimdTransform( matrix, factor ); }
+#ifdef BUILD_INTRINSICS_TRANSFORMS
+void runIntrinsics( t_dataVector& matrix, t_dataVector& factor, size_t ) { intrinsicsTransformFloat( matrix, factor ); }
+void runUnrolledIntrinsics( t_dataVector& matrix, t_dataVector& factor, size_t ) { unrolledIntrinsicsTransformFloat( matrix, factor ); }
+#endif // BUILD_INTRINSICS_TRANSFORMS
+
+#ifdef _OPENMP
+// OpenMP team size for one call, restored afterwards
+class ThreadCount
+{
+public:
+    explicit ThreadCount( size_t threads ) : previous_( omp_get_max_threads() ) { omp_set_num_threads( static_cast<int>( threads ) ); }
+    ~ThreadCount() { omp_set_num_threads( previous_ ); }
+
+private:
+    int previous_;
+};
+
+void runSimdOpenMP( t_dataVector& matrix, t_dataVector& factor, size_t threads )
+{
+    ThreadCount count( threads );
+    simdOpenMPTransform( matrix, factor );
+}
+
+void runUnrolledSimdOpenMP( t_dataVector& matrix, t_dataVector& factor, size_t threads )
+{
+    ThreadCount count( threads );
+    unrolledSimdOpenMPTransform( matrix, factor );
+}
+
+#ifdef BUILD_TASK_TRANSFORMS
+void runTasks( t_dataVector& matrix, t_dataVector& factor, size_t tileSize ) { taskOpenMPTransform( matrix, factor, tileSize ); }
+#else
+// A tuning file from a build with tasks still runs, on the plain OpenMP kernel
+void runTasks( t_dataVector& matrix, t_dataVector& factor, size_t ) { simdOpenMPTransform( matrix, factor ); }
+#endif // BUILD_TASK_TRANSFORMS
+#endif // _OPENMP
+
+struct Kernel
+{
+    const char* name_;
+    t_tunedKernel run_;
+};
+
+const Kernel kernels_[] = {
+    { "simd",                   &runSimd },
+    { "simd-unrolled",          &runUnrolledSimd },
+    { "simd-fixed",             &runFixedSimd },
+    { "simd-blocked",           &runBlockedSimd },
+    { "dispatch-simd",          &runDispatchSimd },
+#ifdef BUILD_INTRINSICS_TRANSFORMS
+    { "intrinsics",             &runIntrinsics },
+    { "intrinsics-unrolled",    &runUnrolledIntrinsics },
+#endif // BUILD_INTRINSICS_TRANSFORMS
+#ifdef _OPENMP
+    { "simd-openmp",            &runSimdOpenMP },
+    { "simd-openmp-unrolled",   &runUnrolledSimdOpenMP },
+    { "simd-tasks",             &runTasks },
+#endif // _OPENMP
+};
+
+t_tunedKernel findKernel( const std::string& name )
+{
+    for( const Kernel& kernel : kernels_ )
+    {
+        if( name == kernel.name_ )
+            return( kernel.run_ );
+    }
+    return( nullptr );
+}
+
+size_t getThreads()
+{
+#ifdef _OPENMP
+    return( static_cast<size_t>( omp_get_max_threads() ) );
+#else
+    return( std::max<size_t>( std::thread::hardware_concurrency(), 1 ) );
+#endif // _OPENMP
+}
+
+// What a tuning depends on besides the code: a file from another ISA or thread
+// count is tuned again
+std::string getTuningHeader()
+{
+    std::ostringstream header;
+    header << "# boostSimd tuning isa " << getIsaName( detectIsa() ) << " threads " << getThreads();
+    return( header.str() );
+}
+
+struct Tuned
+{
+    size_t width_;
+    t_tunedKernel run_;
+    size_t parameter_;
+};
+
+std::vector<TuneEntry> tuning_;
+std::vector<Tuned> tuned_;
+} // namespace
+
+std::vector<TuneCandidate> getTuneCandidates()
+{
+    std::vector<TuneCandidate> candidates = {
+        { "simd", 0 }, { "simd-unrolled", 0 }, { "simd-fixed", 0 }, { "dispatch-simd", 0 },
+        { "simd-blocked", 32 }, { "simd-blocked", 64 }, { "simd-blocked", 128 },
+#ifdef BUILD_INTRINSICS_TRANSFORMS
+        { "intrinsics", 0 }, { "intrinsics-unrolled", 0 },
+#endif // BUILD_INTRINSICS_TRANSFORMS
+    };
+#ifdef _OPENMP
+    // Powers of two up to the whole machine, and the whole machine
+    size_t threads = getThreads();
+    for( size_t count = 2; count < threads * 2; count *= 2 )
+    {
+        candidates.push_back( { "simd-openmp", std::min( count, threads ) } );
+        candidates.push_back( { "simd-openmp-unrolled", std::min( count, threads ) } );
+    }
+#ifdef BUILD_TASK_TRANSFORMS
+    for( size_t tileSize : { 64, 128, 256 } )
+    {
+        candidates.push_back( { "simd-tasks", tileSize } );
+    }
+#endif // BUILD_TASK_TRANSFORMS
+#endif // _OPENMP
+    return( candidates );
+}
+
+std::vector<TuneEntry> autoTune( const std::vector<size_t>& widths, const BenchmarkOptions& options, std::ostream* log )
+{
+    std::vector<TuneCandidate> candidates = getTuneCandidates();
+    std::vector<TuneEntry> entries;
+    for( size_t width : widths )
+    {
+        std::mt19937 generator( static_cast<unsigned>( width ) );
+        std::uniform_real_distribution<t_dataType> distribution( -1, 1 );
+        t_dataVector baseMatrix( width * width );
+        t_dataVector baseFactor( width );
+        std::generate( baseMatrix.begin(), baseMatrix.end(), [&]() { return distribution( generator ); } );
+        std::generate( baseFactor.begin(), baseFactor.end(), [&]() { return distribution( generator ); } );
+        for( size_t y = 0; y < width; ++y )
+        {
+            baseMatrix[ getIndex( y, y, width ) ] += static_cast<t_dataType>( width );
+        }
+
+        TuneEntry best = { width, "", 0, std::numeric_limits<double>::infinity() };
+        for( const TuneCandidate& candidate : candidates )
+        {
+            t_tunedKernel kernel = findKernel( candidate.kernel_ );
+            size_t parameter = candidate.parameter_;
+            auto candidateTransform = [kernel, parameter]( t_dataVector& matrix, t_dataVector& factor )
+            {
+                kernel( matrix, factor, parameter );
+            };
+
+            // A fast but wrong candidate must never be written to the tuning file
+            VerifyResult check = verifyTransform( candidateTransform, width, static_cast<unsigned>( generator() ) );
+            if( !check.passed_ )
+            {
+                if( log )
+                    *log << "Skipped " << candidate.kernel_ << " " << candidate.parameter_ << " at " << width
+                         << ", it fails verification" << std::endl;
+                continue;
+            }
+            BenchmarkResult result = runBenchmark( candidate.kernel_, candidateTransform, baseMatrix, baseFactor, options );
+            if( result.median_ < best.seconds_ )
+                best = { width, candidate.kernel_, candidate.parameter_, result.median_ };
+        }
+        entries.push_back( best );
+        if( log )
+        {
+            *log << "Tuned " << std::setw( 6 ) << width << ": " << best.kernel_;
+            if( best.parameter_ )
+                *log << " " << best.parameter_;
+            *log << " " << std::scientific << std::setprecision( 3 ) << best.seconds_ << "s" << std::endl;
+        }
+    }
+    return( entries );
+}
+
+std::string getTuningPath( const std::string& directory )
+{
+    std::string host = "host";
+#ifdef __linux__
+    char name[ 256 ] = {};
+    if( gethostname( name, sizeof( name ) - 1 ) == 0 && name[ 0 ] )
+        host = name;
+#endif // __linux__
+    return( directory + "/boostSimdTuning." + host );
+}
+
+bool readTuning( const std::string& path, std::vector<TuneEntry>& entries )
+{
+    std::ifstream file( path );
+    std::string header;
+    if( !std::getline( file, header ) || header != getTuningHeader() )
+        return( false );
+
+    entries.clear();
+    TuneEntry entry;
+    while( file >> entry.width_ >> entry.kernel_ >> entry.parameter_ >> entry.seconds_ )
+    {
+        if( !findKernel( entry.kernel_ ) )
+            return( false );
+        entries.push_back( entry );
+    }
+    return( !entries.empty() );
+}
+
+void writeTuning( const std::string& path, const std::vector<TuneEntry>& entries )
+{
+    std::ofstream file( path );
+    file << getTuningHeader() << std::endl;
+    for( const TuneEntry& entry : entries )
+    {
+        file << entry.width_ << " " << entry.kernel_ << " " << entry.parameter_ << " "
+             << std::scientific << std::setprecision( 6 ) << entry.seconds_ << std::endl;
+    }
+}
+
+void loadTuning( const std::string& path, const std::vector<size_t>& widths, const BenchmarkOptions& options, std::ostream* log )
+{
+    if( !readTuning( path, tuning_ ) )
+    {
+        if( log )
+            *log << "Tuning " << path << " for this host" << std::endl;
+        tuning_ = autoTune( widths, options, log );
+        writeTuning( path, tuning_ );
+    }
+
+    tuned_.clear();
+    for( const TuneEntry& entry : tuning_ )
+    {
+        tuned_.push_back( { entry.width_, findKernel( entry.kernel_ ), entry.parameter_ } );
+    }
+}
+
+const std::vector<TuneEntry>& getTuning()
+{
+    return( tuning_ );
+}
+
+// Closest tuned width on a log scale, 300 takes the kernel of 256 rather than 512
+void tunedTransform( t_dataVector& matrix, t_dataVector& factor )
+{
+    if( tuned_.empty() )
+    {
+        simdTransform( matrix, factor );
+        return;
+    }
+
+    double width = static_cast<double>( factor.size() );
+    auto distance = [width]( const Tuned& tuned ) { return( std::abs( std::log( tuned.width_ / width ) ) ); };
+    const Tuned& best = *std::min_element( tuned_.begin(), tuned_.end(),
+                                           [&]( const Tuned& lhs, const Tuned& rhs ) { return( distance( lhs ) < distance( rhs ) ); } );
+    best.run_( matrix, factor, best.parameter_ );
+}
+
+void solve( t_dataVector& matrix, t_dataVector& factor )
+{
+    tunedTransform( matrix, factor );
+    backSubstitution( matrix, factor );
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#ifndef __AUTO_TUNE__
+#define __AUTO_TUNE__
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "boostSimd.h"
+#include "benchmark.h"
+
+// One tuned width: the kernel that ran fastest there, its parameter (block or tile
+// size, OpenMP threads, 0 for none) and its median time
+struct TuneEntry
+{
+    size_t width_;
+    std::string kernel_;
+    size_t parameter_;
+    double seconds_;
+};
+
+// Kernels the tuner tries, each with the parameter values worth trying on this host
+struct TuneCandidate
+{
+    std::string kernel_;
+    size_t parameter_;
+};
+std::vector<TuneCandidate> getTuneCandidates();
+
+// Times every candidate at each width and keeps the fastest, progress goes to log
+std::vector<TuneEntry> autoTune( const std::vector<size_t>& widths, const BenchmarkOptions& options, std::ostream* log );
+
+// boostSimdTuning.<host name> in directory. The file records the ISA and thread count it
+// was tuned with, readTuning rejects it (returns false) when they differ from this host.
+std::string getTuningPath( const std::string& directory = "." );
+bool readTuning( const std::string& path, std::vector<TuneEntry>& entries );
+void writeTuning( const std::string& path, const std::vector<TuneEntry>& entries );
+
+// Reads the tuning file, tuning the widths and writing it first when it is missing or
+// stale, and makes it the table tunedTransform and solve dispatch on. Call it before
+// solving from several threads.
+void loadTuning( const std::string& path, const std::vector<size_t>& widths, const BenchmarkOptions& options, std::ostream* log );
+const std::vector<TuneEntry>& getTuning();
+
+// Runs the kernel tuned for the closest width, simdTransform without a tuning.
+// solve also back substitutes, factor receives the solution.
+void tunedTransform( t_dataVector& matrix, t_dataVector& factor );
+void solve( t_dataVector& matrix, t_dataVector& factor );
+
+#endif // __AUTO_TUNE__
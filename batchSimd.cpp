@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#include <algorithm>
+
+#include <boost/simd/pack.hpp>
+#include <boost/simd/function/fma.hpp>
+
+#include "boostSimd.h"
+
+namespace bs = boost::simd;
+
+namespace
+{
+template< typename T >
+using t_batchPack = bs::pack<T>;
+
+template< typename T >
+inline size_t getBatchIndex( size_t index, size_t matrix, size_t size )
+{
+    size_t lanes = t_batchPack<T>::static_size;
+	return( ((matrix / lanes) * size + index) * lanes + matrix % lanes );
+}
+} // namespace
+
+template< typename T >
+size_t getBatchLanes()
+{
+    return( t_batchPack<T>::static_size );
+}
+
+template< typename T >
+size_t getBatchSize( size_t count, size_t size )
+{
+    size_t lanes = t_batchPack<T>::static_size;
+    return( ((count + lanes - 1) / lanes) * lanes * size );
+}
+
+// Lanes past the last system repeat it, so unused lanes always hold a solvable system
+template< typename T >
+void interleaveBatch( const t_vector<T>& source, t_vector<T>& batch, size_t size )
+{
+    size_t count = source.size() / size;
+    batch.resize( getBatchSize<T>( count, size ) );
+    for( size_t matrix = 0; matrix < batch.size() / size; ++matrix )
+    {
+        size_t sourceMatrix = std::min( matrix, count - 1 );
+        for( size_t index = 0; index < size; ++index )
+        {
+            batch[ getBatchIndex<T>( index, matrix, size ) ] = source[ getIndex( index, sourceMatrix, size ) ];
+        }
+    }
+}
+
+template< typename T >
+void deinterleaveBatch( const t_vector<T>& batch, t_vector<T>& destination, size_t size )
+{
+    size_t count = destination.size() / size;
+    for( size_t matrix = 0; matrix < count; ++matrix )
+    {
+        for( size_t index = 0; index < size; ++index )
+        {
+            destination[ getIndex( index, matrix, size ) ] = batch[ getBatchIndex<T>( index, matrix, size ) ];
+        }
+    }
+}
+
+// Every pack lane belongs to a different system, so the whole elimination is
+// straight packed code whatever the width, with no ragged row tail.
+template< typename T >
+void batchedSimdTransform( t_vector<T>& matrices, t_vector<T>& factors, size_t width )
+{
+    using t_pack = t_batchPack<T>;
+
+    size_t size = width * width;
+    size_t groups = factors.size() / (width * t_pack::static_size);
+    t_pack* packMatrices = reinterpret_cast<t_pack*>( matrices.data() );
+    t_pack* packFactors = reinterpret_cast<t_pack*>( factors.data() );
+
+    for( size_t group = 0; group < groups; ++group )
+    {
+        t_pack* packMatrix = packMatrices + group * size;
+        t_pack* packFactor = packFactors + group * width;
+        for( size_t line = 0; line < width - 1; ++line )
+        {
+            t_pack packPivot = packMatrix[ getIndex( line, line, width ) ];
+            for( size_t y = line + 1; y < width; ++y )
+            {
+                t_pack packScale = -(packMatrix[ getIndex( line, y, width ) ] / packPivot);
+                packFactor[ y ] = bs::fma( packScale, packFactor[ line ], packFactor[ y ] );
+
+                t_pack* packLine = &( packMatrix[ getIndex( line, y, width ) ] );
+                t_pack* packBase = &( packMatrix[ getIndex( line, line, width ) ] );
+                for( size_t x = line; x < width; ++x )
+                {
+                    *packLine = bs::fma( packScale, *packBase++, *packLine );
+                    packLine++;
+                }
+            }
+        }
+    }
+}
+
+#define INSTANTIATE_BATCH( T ) \
+template size_t getBatchLanes<T>(); \
+template size_t getBatchSize<T>( size_t count, size_t size ); \
+template void interleaveBatch( const t_vector<T>& source, t_vector<T>& batch, size_t size ); \
+template void deinterleaveBatch( const t_vector<T>& batch, t_vector<T>& destination, size_t size ); \
+template void batchedSimdTransform( t_vector<T>& matrices, t_vector<T>& factors, size_t width );
+
+INSTANTIATE_BATCH( float )
+INSTANTIATE_BATCH( double )
@@ -0,0 +1,397 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+#include <boost/timer/timer.hpp>
+
+#include "benchmark.h"
+#include "solveService.h"
+
+double getEliminationFlops( size_t width )
+{
+    // Pivot step with k rows left: k - 1 rows, each one division, k fma on the
+    // row and one on the factor
+    double flops = 0;
+    for( size_t k = 2; k <= width; ++k )
+    {
+        flops += static_cast<double>( k - 1 ) * (2 * k + 3);
+    }
+    return( flops );
+}
+
+double getEliminationBytes( size_t width, size_t elementBytes )
+{
+    double bytes = 0;
+    for( size_t k = 2; k <= width; ++k )
+    {
+        bytes += 2.0 * static_cast<double>( k - 1 ) * k * elementBytes;
+    }
+    return( bytes );
+}
+
+namespace
+{
+BenchmarkResult getResult( const std::string& variant, size_t width, std::vector<double>& times,
+                           const PerfCounters& counters, const BenchmarkOptions& options,
+                           size_t elementBytes = sizeof( t_dataType ) )
+{
+    std::sort( times.begin(), times.end() );
+    size_t count = times.size();
+
+    BenchmarkResult result;
+    result.variant_ = variant;
+    result.width_ = width;
+    result.samples_ = count;
+    result.min_ = times.front();
+    result.median_ = (count % 2) ? times[ count / 2 ] : (times[ count / 2 - 1 ] + times[ count / 2 ]) / 2;
+    result.p95_ = times[ static_cast<size_t>( std::ceil( 0.95 * count ) ) - 1 ];
+    result.gflops_ = getEliminationFlops( width ) / result.median_ / 1e9;
+    result.gbytes_ = getEliminationBytes( width, elementBytes ) / result.median_ / 1e9;
+    for( size_t i = 0; i < static_cast<size_t>( t_counter::count ); ++i )
+    {
+        result.counters_[ i ] = options.counters_ ? counters.get( static_cast<t_counter>( i ) ) / count
+                                                  : std::numeric_limits<double>::quiet_NaN();
+    }
+    return( result );
+}
+} // namespace
+
+BenchmarkResult runBenchmark( const std::string& variant, t_transform transform,
+                              const t_dataVector& baseMatrix, const t_dataVector& baseFactor,
+                              const BenchmarkOptions& options )
+{
+    return( runBenchmark( variant, t_transformFunction( transform ), baseMatrix, baseFactor, options ) );
+}
+
+BenchmarkResult runBenchmark( const std::string& variant, const t_transformFunction& transform,
+                              const t_dataVector& baseMatrix, const t_dataVector& baseFactor,
+                              const BenchmarkOptions& options )
+{
+    t_dataVector matrix( baseMatrix );
+    t_dataVector factor( baseFactor );
+    if( options.prepare_ )
+        options.prepare_( matrix, factor.size() );
+
+    // Warmup (fill cache, create OpenMP threads, etc).
+    transform( matrix, factor );
+
+    PerfCounters counters;
+    boost::timer::cpu_timer timer;
+    std::vector<double> times;
+    double elapsed = 0;
+    while( times.size() < std::max<size_t>( options.samples_, 1 ) && (times.size() < 3 || elapsed < options.budget_) )
+    {
+        std::copy( baseMatrix.begin(), baseMatrix.end(), matrix.begin() );
+        std::copy( baseFactor.begin(), baseFactor.end(), factor.begin() );
+
+        if( options.counters_ )
+            counters.start();
+        timer.start();
+        transform( matrix, factor );
+        timer.stop();
+        if( options.counters_ )
+            counters.stop();
+
+        times.push_back( static_cast<double>(timer.elapsed().wall) / 1000000000.0 );
+        elapsed += times.back();
+    }
+    return( getResult( variant, baseFactor.size(), times, counters, options ) );
+}
+
+BenchmarkResult runCopyBenchmark( const std::string& variant, t_copyTransform transform,
+                                  const t_dataVector& baseMatrix, const t_dataVector& baseFactor,
+                                  const BenchmarkOptions& options )
+{
+    t_dataVector matrix( baseMatrix.size() );
+    t_dataVector factor( baseFactor );
+    if( options.prepare_ )
+        options.prepare_( matrix, factor.size() );
+
+    transform( baseMatrix, matrix, factor );
+
+    PerfCounters counters;
+    boost::timer::cpu_timer timer;
+    std::vector<double> times;
+    double elapsed = 0;
+    while( times.size() < std::max<size_t>( options.samples_, 1 ) && (times.size() < 3 || elapsed < options.budget_) )
+    {
+        std::copy( baseFactor.begin(), baseFactor.end(), factor.begin() );
+
+        if( options.counters_ )
+            counters.start();
+        timer.start();
+        transform( baseMatrix, matrix, factor );
+        timer.stop();
+        if( options.counters_ )
+            counters.stop();
+
+        times.push_back( static_cast<double>(timer.elapsed().wall) / 1000000000.0 );
+        elapsed += times.back();
+    }
+    return( getResult( variant, baseFactor.size(), times, counters, options ) );
+}
+
+BenchmarkResult runHalfBenchmark( const std::string& variant, t_halfTransform transform,
+                                  const t_halfVector& baseMatrix, const t_dataVector& baseFactor,
+                                  const BenchmarkOptions& options )
+{
+    t_halfVector matrix( baseMatrix );
+    t_dataVector factor( baseFactor );
+
+    transform( matrix, factor );
+
+    PerfCounters counters;
+    boost::timer::cpu_timer timer;
+    std::vector<double> times;
+    double elapsed = 0;
+    while( times.size() < std::max<size_t>( options.samples_, 1 ) && (times.size() < 3 || elapsed < options.budget_) )
+    {
+        std::copy( baseMatrix.begin(), baseMatrix.end(), matrix.begin() );
+        std::copy( baseFactor.begin(), baseFactor.end(), factor.begin() );
+
+        if( options.counters_ )
+            counters.start();
+        timer.start();
+        transform( matrix, factor );
+        timer.stop();
+        if( options.counters_ )
+            counters.stop();
+
+        times.push_back( static_cast<double>(timer.elapsed().wall) / 1000000000.0 );
+        elapsed += times.back();
+    }
+    return( getResult( variant, baseFactor.size(), times, counters, options, sizeof( uint16_t ) ) );
+}
+
+void setupSpdMatrix( t_dataVector& matrix, size_t width, unsigned seed )
+{
+    std::mt19937 generator( seed );
+    std::uniform_real_distribution<t_dataType> distribution( -1, 1 );
+
+    size_t stride = matrix.size() / width;
+    for( size_t y = 0; y < width; ++y )
+    {
+        for( size_t x = 0; x < y; ++x )
+        {
+            matrix[ getIndex( x, y, stride ) ] = matrix[ getIndex( y, x, stride ) ] = distribution( generator );
+        }
+        matrix[ getIndex( y, y, stride ) ] = static_cast<t_dataType>( width );
+    }
+}
+
+double getBackwardError( const t_dataVector& matrix, const t_dataVector& factor, const t_vector<double>& solution )
+{
+    size_t width = factor.size();
+    size_t stride = matrix.size() / width;
+    double residualNorm = 0;
+    double matrixNorm = 0;
+    double solutionNorm = 0;
+    double factorNorm = 0;
+    for( size_t y = 0; y < width; ++y )
+    {
+        double sum = 0;
+        double rowNorm = 0;
+        for( size_t x = 0; x < width; ++x )
+        {
+            sum += static_cast<double>( matrix[ getIndex( x, y, stride ) ] ) * solution[ x ];
+            rowNorm += std::abs( matrix[ getIndex( x, y, stride ) ] );
+        }
+        residualNorm = std::max( residualNorm, std::abs( factor[ y ] - sum ) );
+        matrixNorm = std::max( matrixNorm, rowNorm );
+        solutionNorm = std::max( solutionNorm, std::abs( solution[ y ] ) );
+        factorNorm = std::max( factorNorm, static_cast<double>( std::abs( factor[ y ] ) ) );
+    }
+    // std::max drops NaN, so a solution that is not finite is caught here
+    if( std::any_of( solution.begin(), solution.end(), []( double value ) { return( !std::isfinite( value ) ); } ) )
+        return( std::numeric_limits<double>::infinity() );
+    return( residualNorm / (matrixNorm * solutionNorm + factorNorm) );
+}
+
+double getBackwardError( const t_dataVector& matrix, const t_dataVector& factor, const t_dataVector& solution )
+{
+    return( getBackwardError( matrix, factor, t_vector<double>( solution.begin(), solution.end() ) ) );
+}
+
+namespace
+{
+// The random system of a check, rows matrix.size() / width apart
+void setupVerifySystem( t_dataVector& baseMatrix, t_dataVector& baseFactor, unsigned seed, t_system system )
+{
+    std::mt19937 generator( seed );
+    std::uniform_real_distribution<t_dataType> distribution( -1, 1 );
+
+    size_t width = baseFactor.size();
+    size_t stride = baseMatrix.size() / width;
+    for( size_t y = 0; y < width; ++y )
+    {
+        for( size_t x = 0; x < width; ++x )
+        {
+            baseMatrix[ getIndex( x, y, stride ) ] = distribution( generator );
+        }
+    }
+    std::generate( baseFactor.begin(), baseFactor.end(), [&]() { return distribution( generator ); } );
+
+    // Diagonal dominance keeps the variants without pivoting stable
+    if( system == t_system::spd )
+    {
+        setupSpdMatrix( baseMatrix, width, static_cast<unsigned>( generator() ) );
+    }
+    else
+    {
+        for( size_t y = 0; y < width; ++y )
+        {
+            baseMatrix[ getIndex( y, y, stride ) ] = system == t_system::dominant
+                ? baseMatrix[ getIndex( y, y, stride ) ] + static_cast<t_dataType>( width ) : 0;
+        }
+    }
+}
+} // namespace
+
+VerifyResult verifyTransform( const t_transformFunction& transform, size_t width, unsigned seed, t_system system, bool padded )
+{
+    size_t stride = padded ? getStride<t_dataType>( width ) : width;
+    t_dataVector baseMatrix( width * stride );
+    t_dataVector baseFactor( width );
+    setupVerifySystem( baseMatrix, baseFactor, seed, system );
+
+    VerifyResult result;
+    result.width_ = width;
+    result.seed_ = seed;
+    result.padded_ = padded;
+    result.tolerance_ = 8.0 * width * std::numeric_limits<t_dataType>::epsilon();
+
+    t_dataVector matrix( baseMatrix );
+    t_dataVector factor( baseFactor );
+    try
+    {
+        transform( matrix, factor );
+    }
+    catch( const std::domain_error& error )
+    {
+        result.error_ = std::numeric_limits<double>::infinity();
+        result.passed_ = false;
+        result.failure_ = error.what();
+        return( result );
+    }
+
+    t_vector<double> upper( matrix.begin(), matrix.end() );
+    t_vector<double> solution( factor.begin(), factor.end() );
+    backSubstitution( upper, solution );
+
+    result.error_ = getBackwardError( baseMatrix, baseFactor, solution );
+    result.passed_ = result.error_ <= result.tolerance_;   // false for NaN as well
+    return( result );
+}
+
+VerifyResult verifySolveService( size_t width, unsigned seed )
+{
+    t_dataVector baseMatrix( width * width );
+    t_dataVector baseFactor( width );
+    setupVerifySystem( baseMatrix, baseFactor, seed, t_system::dominant );
+
+    VerifyResult result;
+    result.width_ = width;
+    result.seed_ = seed;
+    result.padded_ = false;
+    result.tolerance_ = 8.0 * width * std::numeric_limits<t_dataType>::epsilon();
+
+    // Every width splits, and the helpers get to the job before its owner
+    SolveService service( 4, 0, 2 );
+    service.setSplitDelay( std::chrono::milliseconds( 20 ) );
+    t_dataVector solution;
+    try
+    {
+        solution = service.submit( baseMatrix, baseFactor ).get();
+    }
+    catch( const std::exception& error )
+    {
+        result.error_ = std::numeric_limits<double>::infinity();
+        result.passed_ = false;
+        result.failure_ = error.what();
+        return( result );
+    }
+
+    result.error_ = getBackwardError( baseMatrix, baseFactor, solution );
+    result.passed_ = result.error_ <= result.tolerance_;
+    return( result );
+}
+
+void writeCsv( std::ostream& out, const std::vector<BenchmarkResult>& results )
+{
+    out << "variant,width,samples,min_s,median_s,p95_s,gflops,gbytes_s";
+    for( size_t i = 0; i < static_cast<size_t>( t_counter::count ); ++i )
+    {
+        out << ',' << PerfCounters::getName( static_cast<t_counter>( i ) );
+    }
+    out << std::endl;
+
+    for( const BenchmarkResult& result : results )
+    {
+        out << '"' << result.variant_ << '"' << ',' << result.width_ << ',' << result.samples_ << ','
+            << std::scientific << std::setprecision( 6 )
+            << result.min_ << ',' << result.median_ << ',' << result.p95_ << ','
+            << std::fixed << std::setprecision( 3 )
+            << result.gflops_ << ',' << result.gbytes_ << std::setprecision( 0 );
+        for( double value : result.counters_ )
+        {
+            out << ',';
+            if( !std::isnan( value ) )
+                out << value;
+        }
+        out << std::endl;
+    }
+}
+
+void writeJson( std::ostream& out, const std::vector<BenchmarkResult>& results, const std::string& isa )
+{
+    out << "{" << std::endl
+        << "  \"isa\": \"" << isa << "\"," << std::endl
+        << "  \"results\": [" << std::endl;
+    for( size_t i = 0; i < results.size(); ++i )
+    {
+        const BenchmarkResult& result = results[ i ];
+        out << "    { \"variant\": \"" << result.variant_ << "\", \"width\": " << result.width_
+            << ", \"samples\": " << result.samples_
+            << std::scientific << std::setprecision( 6 )
+            << ", \"min_s\": " << result.min_ << ", \"median_s\": " << result.median_ << ", \"p95_s\": " << result.p95_
+            << std::fixed << std::setprecision( 3 )
+            << ", \"gflops\": " << result.gflops_ << ", \"gbytes_s\": " << result.gbytes_
+            << std::setprecision( 0 );
+        for( size_t counter = 0; counter < static_cast<size_t>( t_counter::count ); ++counter )
+        {
+            out << ", \"" << PerfCounters::getName( static_cast<t_counter>( counter ) ) << "\": ";
+            if( std::isnan( result.counters_[ counter ] ) )
+                out << "null";
+            else
+                out << result.counters_[ counter ];
+        }
+        out << " }" << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    out << "  ]" << std::endl
+        << "}" << std::endl;
+}
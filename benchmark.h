@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#ifndef __BENCHMARK__
+#define __BENCHMARK__
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "boostSimd.h"
+#include "halfSimd.h"
+#include "perfCounters.h"
+
+using t_transform = void (*)( t_dataVector& matrix, t_dataVector& factor );
+// What runBenchmark times, a t_transform or a lambda holding the extra arguments
+using t_transformFunction = std::function<void( t_dataVector& matrix, t_dataVector& factor )>;
+using t_prepare = void (*)( t_dataVector& matrix, size_t width );
+using t_copyTransform = void (*)( const t_dataVector& source, t_dataVector& matrix, t_dataVector& factor );
+using t_halfTransform = void (*)( t_halfVector& matrix, t_dataVector& factor );
+
+struct BenchmarkOptions
+{
+    size_t samples_ = 15;   // timed runs per variant and size, at most
+    double budget_ = 2.0;   // seconds per variant and size, at least three runs are kept
+    bool counters_ = false; // record hardware counters around the timed runs
+    t_prepare prepare_ = nullptr;   // called once on the working matrix, e.g. to place its pages
+};
+
+struct BenchmarkResult
+{
+    std::string variant_;
+    size_t width_;
+    size_t samples_;
+    double min_;            // seconds
+    double median_;
+    double p95_;
+    double gflops_;         // from the median
+    double gbytes_;
+    double counters_[ static_cast<size_t>( t_counter::count ) ];   // per run, NaN if not recorded
+};
+
+// Useful work of one elimination, about 2n^3/3 flops
+double getEliminationFlops( size_t width );
+
+// Streaming model: every pivot step reads and writes the whole trailing submatrix
+double getEliminationBytes( size_t width, size_t elementBytes = sizeof( t_dataType ) );
+
+// Times transform on copies of matrix and factor. The copy that resets them
+// before each run is outside the timed region.
+BenchmarkResult runBenchmark( const std::string& variant, t_transform transform,
+                              const t_dataVector& matrix, const t_dataVector& factor,
+                              const BenchmarkOptions& options );
+BenchmarkResult runBenchmark( const std::string& variant, const t_transformFunction& transform,
+                              const t_dataVector& matrix, const t_dataVector& factor,
+                              const BenchmarkOptions& options );
+
+// Times transform from the untouched source matrix into one reused destination,
+// so whatever copying the transform does is timed. Only the factor reset is not.
+BenchmarkResult runCopyBenchmark( const std::string& variant, t_copyTransform transform,
+                                  const t_dataVector& matrix, const t_dataVector& factor,
+                                  const BenchmarkOptions& options );
+
+// runBenchmark for a matrix in 16 bit storage, GB/s counted on 2 byte elements
+BenchmarkResult runHalfBenchmark( const std::string& variant, t_halfTransform transform,
+                                  const t_halfVector& matrix, const t_dataVector& factor,
+                                  const BenchmarkOptions& options );
+
+// System verifyTransform solves
+//  dominant  diagonally dominant, safe for the variants without pivoting
+//  general   random entries around a zero diagonal, so rows have to be swapped, for
+//            the pivoting variants
+//  spd       symmetric positive definite, for the Cholesky variants
+enum class t_system { dominant, general, spd };
+
+struct VerifyResult
+{
+    size_t width_;
+    unsigned seed_;
+    bool padded_;
+    double error_;          // normwise backward error
+    double tolerance_;
+    bool passed_;
+    std::string failure_;   // what the transform threw, empty when it returned
+};
+
+// Solves a random system of the given width with transform, back substitutes in
+// double and checks ||b - Ax|| / (||A|| ||x|| + ||b||), in the infinity norm,
+// against a tolerance that grows with the width. padded stores the rows
+// getStride( width ) apart, the layout the fast paths are written for; otherwise
+// they are width apart, which those paths leave to unalignedSimdTransform. A
+// transform that throws fails the check with its message.
+VerifyResult verifyTransform( const t_transformFunction& transform, size_t width, unsigned seed,
+                              t_system system = t_system::dominant, bool padded = false );
+
+// Solves a random diagonally dominant system on a SolveService that splits it,
+// the owner held back so its helpers start first, and checks it as above.
+VerifyResult verifySolveService( size_t width, unsigned seed );
+
+// Normwise backward error ||b - Ax|| / (||A|| ||x|| + ||b||) in the infinity norm,
+// accumulated in double with rows matrix.size() / width apart. Infinity for a
+// solution that is not finite.
+double getBackwardError( const t_dataVector& matrix, const t_dataVector& factor, const t_vector<double>& solution );
+double getBackwardError( const t_dataVector& matrix, const t_dataVector& factor, const t_dataVector& solution );
+
+// Random symmetric positive definite matrix: symmetric entries in [-1, 1] and a diagonal
+// above the row sums. Rows are matrix.size() / width long, padding left as it is.
+void setupSpdMatrix( t_dataVector& matrix, size_t width, unsigned seed );
+
+void writeCsv( std::ostream& out, const std::vector<BenchmarkResult>& results );
+void writeJson( std::ostream& out, const std::vector<BenchmarkResult>& results, const std::string& isa );
+
+#endif // __BENCHMARK__
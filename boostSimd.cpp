@@ -26,6 +26,7 @@
 #include <iomanip>
 #include <vector>
 #include <string>
+#include <algorithm>
 
 #include <xmmintrin.h>
 
@@ -34,6 +35,7 @@
 #include <boost/simd/function/multiplies.hpp>
 
 #include <boost/simd/function/load.hpp>
+#include <boost/simd/function/aligned_load.hpp>
 #include <boost/simd/function/aligned_store.hpp>
 #include <boost/simd/function/stream.hpp>
 //#include <boost/simd/prefetch.hpp>
@@ -51,41 +53,76 @@
 
 namespace bs = boost::simd;
 
-inline size_t getIndex( size_t x, size_t y, size_t width )
+namespace
 {
-	return( y * width + x );
+// Pivot stage of one line: gathers the column under the pivot once, turns it
+// into multipliers with a single reciprocal and packed multiplies and applies
+// them to the factor with packed fma. The row updates then only read scales.
+template< typename T >
+void computeMultipliers( const t_vector<T>& matrix, t_vector<T>& factor, size_t line, size_t stride, t_vector<T>& scales )
+{
+	using t_pack = bs::pack<T>;
+
+	size_t width = factor.size();
+    size_t count = width - line - 1;
+    for( size_t y = 0; y < count; ++y )
+    {
+        scales[ y ] = matrix[ getIndex( line, line + 1 + y, stride ) ];
+    }
+
+    T reciprocal = 1 / matrix[ getIndex( line, line, stride ) ];
+    t_pack packReciprocal( reciprocal );
+    t_pack packFactor( -factor[ line ] );
+    T* pFactor = factor.data() + line + 1;
+    size_t y = 0;
+    for( ; y + t_pack::static_size <= count; y += t_pack::static_size )
+    {
+        t_pack packScale = bs::aligned_load<t_pack>( scales.data() + y ) * packReciprocal;
+        bs::aligned_store( packScale, scales.data() + y );
+        bs::store( bs::fma( packScale, packFactor, bs::load<t_pack>( pFactor + y ) ), pFactor + y );
+    }
+    for( ; y < count; ++y )
+    {
+        scales[ y ] *= reciprocal;
+        pFactor[ y ] = bs::fma( scales[ y ], -factor[ line ], pFactor[ y ] );
+    }
 }
+} // namespace
 
-void simpleTransform( t_dataVector& matrix, t_dataVector& factor )
+template< typename T >
+void simpleTransform( t_vector<T>& matrix, t_vector<T>& factor )
 {
     size_t width = factor.size( );
+    size_t stride = matrix.size() / width;
     for( size_t line = 0; line < width - 1; ++line )
     {
         for( size_t y = line + 1; y < width; ++y )
         {
-             t_dataType scale = matrix[ getIndex( line, y, width ) ] / matrix[ getIndex( line, line, width ) ];
+             T scale = matrix[ getIndex( line, y, stride ) ] / matrix[ getIndex( line, line, stride ) ];
             factor[ y ] -= scale * factor[ line ];
 
             for( size_t x = line; x < width; ++x )
             {
-                matrix[ getIndex( x, y, width ) ] -= scale * matrix[ getIndex( x, line, width ) ];
+                matrix[ getIndex( x, y, stride ) ] -= scale * matrix[ getIndex( x, line, stride ) ];
             }
         }
     }
 }
 
-void vectorizedTransform( t_dataVector& matrix, t_dataVector& factor )
+template< typename T >
+void vectorizedTransform( t_vector<T>& matrix, t_vector<T>& factor )
 {
     size_t width = factor.size( );
+    size_t stride = matrix.size() / width;
     for( size_t line = 0; line < width - 1; ++line )
     {
         for( size_t y = line + 1; y < width; ++y )
         {
-             t_dataType scale = matrix[ getIndex( line, y, width ) ] / matrix[ getIndex( line, line, width ) ];
+             T scale = matrix[ getIndex( line, y, stride ) ] / matrix[ getIndex( line, line, stride ) ];
             factor[ y ] -= scale * factor[ line ];
 
-            t_dataType* pBase = &( matrix[ getIndex( line, line, width ) ] );
-            t_dataType* pLine = &( matrix[ getIndex( line, y, width ) ] );
+            T* pBase = &( matrix[ getIndex( line, line, stride ) ] );
+            T* pLine = &( matrix[ getIndex( line, y, stride ) ] );
             for( size_t x = line; x < width; ++x )
             {
                 *pLine++ -= scale * *pBase++;
@@ -94,21 +131,23 @@ void vectorizedTransform( t_dataVector& matrix, t_dataVector& factor )
     }
 }
 
-void unrolledTransform( t_dataVector& matrix, t_dataVector& factor )
+template< typename T >
+void unrolledTransform( t_vector<T>& matrix, t_vector<T>& factor )
 {
 	size_t width = factor.size();
+	size_t stride = matrix.size() / width;
 	for( size_t line = 0; line < width - 1; ++line )
 	{
 		size_t endWidth =  line + ((width - line) & ~(3));
 
 		for( size_t y = line + 1; y < width; ++y )
 		{
-			 t_dataType scale = matrix[ getIndex( line, y, width ) ] / matrix[ getIndex( line, line, width ) ];
+			 T scale = matrix[ getIndex( line, y, stride ) ] / matrix[ getIndex( line, line, stride ) ];
             factor[ y ] -= scale * factor[ line ];
 
 			size_t x = line;
-            t_dataType* pBase = &( matrix[ getIndex( line, line, width ) ] );
-            t_dataType* pLine = &( matrix[ getIndex( line, y, width ) ] );
+            T* pBase = &( matrix[ getIndex( line, line, stride ) ] );
+            T* pLine = &( matrix[ getIndex( line, y, stride ) ] );
 			while( x < endWidth )
 			{
                 *pLine++ -= scale * *pBase++;
@@ -129,38 +168,42 @@ void unrolledTransform( t_dataVector& matrix, t_dataVector& factor )
 }
 
 #ifdef _OPENMP
-void openMPTransform(t_dataVector& matrix, t_dataVector& factor)
+template< typename T >
+void openMPTransform(t_vector<T>& matrix, t_vector<T>& factor)
 {
     int width = static_cast<int>(factor.size());
+    int stride = static_cast<int>( matrix.size() ) / width;
     for (int line = 0; line < width - 1; ++line)
     {
 #pragma omp parallel for
         for (int y = line + 1; y < width; ++y)
         {
-            t_dataType scale = matrix[getIndex(line, y, width)] / matrix[getIndex(line, line, width)];
+            T scale = matrix[getIndex(line, y, stride)] / matrix[getIndex(line, line, stride)];
             factor[y] -= scale * factor[line];
 
             for (size_t x = line; x < width; ++x)
             {
-                matrix[getIndex(x, y, width)] -= scale * matrix[getIndex(x, line, width)];
+                matrix[getIndex(x, y, stride)] -= scale * matrix[getIndex(x, line, stride)];
             }
         }
     }
 }
 
-void vectorizedOpenMPTransform(t_dataVector& matrix, t_dataVector& factor)
+template< typename T >
+void vectorizedOpenMPTransform(t_vector<T>& matrix, t_vector<T>& factor)
 {
     int width = static_cast<int>(factor.size());
+    int stride = static_cast<int>( matrix.size() ) / width;
     for (int line = 0; line < width - 1; ++line)
     {
 #pragma omp parallel for
         for (int y = line + 1; y < width; ++y)
         {
-            t_dataType scale = matrix[getIndex(line, y, width)] / matrix[getIndex(line, line, width)];
+            T scale = matrix[getIndex(line, y, stride)] / matrix[getIndex(line, line, stride)];
             factor[y] -= scale * factor[line];
 
-            t_dataType* pBase = &(matrix[getIndex(line, line, width)]);
-            t_dataType* pLine = &(matrix[getIndex(line, y, width)]);
+            T* pBase = &(matrix[getIndex(line, line, stride)]);
+            T* pLine = &(matrix[getIndex(line, y, stride)]);
             for (int x = line; x < width; ++x)
             {
                 *pLine++ -= scale * *pBase++;
@@ -169,9 +212,11 @@ void vectorizedOpenMPTransform(t_dataVector& matrix, t_dataVector& factor)
     }
 }
 
-void unrolledOpenMPTransform(t_dataVector& matrix, t_dataVector& factor)
+template< typename T >
+void unrolledOpenMPTransform(t_vector<T>& matrix, t_vector<T>& factor)
 {
 	int width = static_cast<int>(factor.size());
+	int stride = static_cast<int>( matrix.size() ) / width;
 	for( int line = 0; line < width - 1; ++line )
 	{
 		#pragma omp parallel for
@@ -179,12 +224,12 @@ void unrolledOpenMPTransform(t_dataVector& matrix, t_dataVector& factor)
 		{
 			int endWidth = line + ((width - line) & ~(3));
 
-			 t_dataType scale = matrix[ getIndex( line, y, width ) ] / matrix[ getIndex( line, line, width ) ];
+			 T scale = matrix[ getIndex( line, y, stride ) ] / matrix[ getIndex( line, line, stride ) ];
             factor[ y ] -= scale * factor[ line ];
 
 			int x = line;
-            t_dataType* pBase = &( matrix[ getIndex( line, line, width ) ] );
-            t_dataType* pLine = &( matrix[ getIndex( line, y, width ) ] );
+            T* pBase = &( matrix[ getIndex( line, line, stride ) ] );
+            T* pLine = &( matrix[ getIndex( line, y, stride ) ] );
 			while( x < endWidth )
 			{
                 *pLine++ -= scale * *pBase++;
@@ -205,22 +250,51 @@ void unrolledOpenMPTransform(t_dataVector& matrix, t_dataVector& factor)
 }
 #endif // _OPENMP
 
-void simdTransform( t_dataVector& matrix, t_dataVector& factor )
+namespace
+{
+// First pivot line of an out of place transform: row 0 copied, every other row
+// written once as its source row minus the scaled source pivot row, padding
+// included, so matrix never needs a copy pass of its own
+template< typename T >
+void copyFirstLine( const t_vector<T>& source, t_vector<T>& matrix, t_vector<T>& factor, size_t y, size_t stride )
+{
+	using t_pack = bs::pack<T>;
+
+    const t_pack* packBase = reinterpret_cast<const t_pack*>( source.data() );
+    const t_pack* packSource = packBase + getIndex( 0, y, stride ) / t_pack::static_size;
+    t_pack* packLine = reinterpret_cast<t_pack*>( matrix.data() ) + getIndex( 0, y, stride ) / t_pack::static_size;
+    if( y == 0 )
+    {
+        std::copy( packSource, packSource + stride / t_pack::static_size, packLine );
+        return;
+    }
+
+    T scale = source[ getIndex( 0, y, stride ) ] / source[ 0 ];
+    factor[ y ] = bs::fma( -scale, factor[ 0 ], factor[ y ] );
+    t_pack packScale( -scale );
+    for( size_t x = 0; x < stride; x += t_pack::static_size )
+    {
+        *packLine++ = bs::fma( packScale, *packBase++, *packSource++ );
+    }
+}
+
+template< typename T >
+void simdEliminate( t_vector<T>& matrix, t_vector<T>& factor, size_t stride, size_t firstLine )
 {
-	using t_pack = bs::pack<t_dataType>;
+	using t_pack = bs::pack<T>;
 
 	size_t width = factor.size();
     t_pack* packMatrix = reinterpret_cast<t_pack*>( matrix.data() );
-	for( size_t line = 0; line < width - 1; ++line )
+	for( size_t line = firstLine; line < width - 1; ++line )
 	{
         size_t normLine = line & ~(static_cast<size_t>(t_pack::static_size - 1));
 		for( size_t y = line + 1; y < width; ++y )
 		{
-            t_dataType scale = matrix[ getIndex( line, y, width ) ] / matrix[ getIndex( line, line, width ) ];
+            T scale = matrix[ getIndex( line, y, stride ) ] / matrix[ getIndex( line, line, stride ) ];
             factor[ y ] = bs::fma( -scale, factor[ line ], factor[ y ] );
 
-            t_pack* packLine = &( packMatrix[ getIndex( normLine, y, width ) / t_pack::static_size ] );
-            t_pack* packBase = &( packMatrix[ getIndex( normLine, line, width ) / t_pack::static_size ] );
+            t_pack* packLine = &( packMatrix[ getIndex( normLine, y, stride ) / t_pack::static_size ] );
+            t_pack* packBase = &( packMatrix[ getIndex( normLine, line, stride ) / t_pack::static_size ] );
             t_pack packScale( -scale );
             for( size_t x = normLine; x < width; x += t_pack::static_size )
 			{
@@ -230,25 +304,161 @@ void simdTransform( t_dataVector& matrix, t_dataVector& factor )
 		}
 	}
 }
+} // namespace
+
+template< typename T >
+void simdTransform( t_vector<T>& matrix, t_vector<T>& factor )
+{
+	using t_pack = bs::pack<T>;
+
+	size_t stride = matrix.size() / factor.size();
+    if( stride % t_pack::static_size )
+    {
+        unalignedSimdTransform( matrix, factor );
+        return;
+    }
+    simdEliminate( matrix, factor, stride, 0 );
+}
+
+template< typename T >
+void simdTransform( const t_vector<T>& source, t_vector<T>& matrix, t_vector<T>& factor )
+{
+	using t_pack = bs::pack<T>;
+
+	size_t width = factor.size();
+	size_t stride = source.size() / width;
+    matrix.resize( source.size() );
+    if( stride % t_pack::static_size )
+    {
+        std::copy( source.begin(), source.end(), matrix.begin() );
+        unalignedSimdTransform( matrix, factor );
+        return;
+    }
+    for( size_t y = 0; y < width; ++y )
+    {
+        copyFirstLine( source, matrix, factor, y, stride );
+    }
+    simdEliminate( matrix, factor, stride, 1 );
+}
+
+namespace
+{
+size_t streamPrefetchLines_ = 8;
+size_t streamThreshold_ = 32 * 1024 * 1024;
+} // namespace
+
+void setStreamTuning( size_t prefetchLines, size_t thresholdBytes )
+{
+    streamPrefetchLines_ = prefetchLines;
+    streamThreshold_ = thresholdBytes;
+}
+
+template< typename T >
+void streamSimdTransform( t_vector<T>& matrix, t_vector<T>& factor )
+{
+    if( matrix.size() * sizeof( T ) < streamThreshold_ )
+    {
+        simdTransform( matrix, factor );
+        return;
+    }
+    streamSimdTransform( matrix, factor, streamPrefetchLines_ );
+}
+
+// Rows leave through non-temporal stores, so a trailing matrix larger than the
+// last level cache does not evict the pivot row on its way out. The loads run
+// prefetchLines cache lines ahead, across row ends, as the rows are contiguous.
+template< typename T >
+void streamSimdTransform( t_vector<T>& matrix, t_vector<T>& factor, size_t prefetchLines )
+{
+	using t_pack = bs::pack<T>;
+
+	size_t width = factor.size();
+	size_t stride = matrix.size() / width;
+    if( stride % t_pack::static_size )
+    {
+        unalignedSimdTransform( matrix, factor );
+        return;
+    }
+    size_t prefetchDistance = prefetchLines * 64 / sizeof( T );
+	for( size_t line = 0; line < width - 1; ++line )
+	{
+        size_t normLine = line & ~(static_cast<size_t>(t_pack::static_size - 1));
+        const T* pBase = &( matrix[ getIndex( 0, line, stride ) ] );
+		for( size_t y = line + 1; y < width; ++y )
+		{
+            T* pLine = &( matrix[ getIndex( 0, y, stride ) ] );
+            T scale = pLine[ line ] / pBase[ line ];
+            factor[ y ] = bs::fma( -scale, factor[ line ], factor[ y ] );
+
+            t_pack packScale( -scale );
+            for( size_t x = normLine; x < width; x += t_pack::static_size )
+			{
+                _mm_prefetch( reinterpret_cast<const char*>( pLine + x + prefetchDistance ), _MM_HINT_T0 );
+                bs::stream( bs::fma( packScale, bs::aligned_load<t_pack>( pBase + x ), bs::aligned_load<t_pack>( pLine + x ) ), pLine + x );
+			}
+		}
+	}
+    _mm_sfence();
+}
+
+template< typename T >
+void scaledSimdTransform( t_vector<T>& matrix, t_vector<T>& factor )
+{
+	using t_pack = bs::pack<T>;
+
+	size_t width = factor.size();
+	size_t stride = matrix.size() / width;
+    if( stride % t_pack::static_size )
+    {
+        unalignedSimdTransform( matrix, factor );
+        return;
+    }
+    t_vector<T> scales( width );
+    t_pack* packMatrix = reinterpret_cast<t_pack*>( matrix.data() );
+	for( size_t line = 0; line < width - 1; ++line )
+	{
+        computeMultipliers( matrix, factor, line, stride, scales );
+
+        size_t normLine = line & ~(static_cast<size_t>(t_pack::static_size - 1));
+        const t_pack* packBase = &( packMatrix[ getIndex( normLine, line, stride ) / t_pack::static_size ] );
+		for( size_t y = line + 1; y < width; ++y )
+		{
+            t_pack* packLine = &( packMatrix[ getIndex( normLine, y, stride ) / t_pack::static_size ] );
+            t_pack packScale( -scales[ y - line - 1 ] );
+            for( size_t x = normLine, i = 0; x < width; x += t_pack::static_size, ++i )
+			{
+                packLine[ i ] = bs::fma( packScale, packBase[ i ], packLine[ i ] );
+			}
+		}
+	}
+}
 
-void simdTransform2( t_dataVector& matrix, t_dataVector& factor )
+template< typename T >
+void simdTransform2( t_vector<T>& matrix, t_vector<T>& factor )
 {
-	using t_pack = bs::pack<t_dataType>;
+	using t_pack = bs::pack<T>;
 
 	size_t width = factor.size();
+	size_t stride = matrix.size() / width;
+    if( stride % t_pack::static_size )
+    {
+        unalignedSimdTransform( matrix, factor );
+        return;
+    }
+    size_t packWidth = (width + t_pack::static_size - 1) & ~(static_cast<size_t>(t_pack::static_size - 1));
 	for( size_t line = 0; line < width - 1; ++line )
 	{
         size_t normLine = line & ~(static_cast<size_t>(t_pack::static_size - 1));
-        t_dataType* pBase = &( matrix[ getIndex( normLine, line, width ) ] );
-        auto baseRange = bs::aligned_input_range( pBase, pBase + (width - normLine) );
+        T* pBase = &( matrix[ getIndex( normLine, line, stride ) ] );
+        auto baseRange = bs::aligned_input_range( pBase, pBase + (packWidth - normLine) );
         for( size_t y = line + 1; y < width; ++y )
 		{
-            t_dataType scale = matrix[ getIndex( line, y, width ) ] / matrix[ getIndex( line, line, width ) ];
+            T scale = matrix[ getIndex( line, y, stride ) ] / matrix[ getIndex( line, line, stride ) ];
             factor[ y ] = bs::fma( -scale, factor[ line ], factor[ y ] );
 
-            t_dataType* pLine = &( matrix[ getIndex( normLine, y, width ) ] );
-            auto lineIt = std::begin( bs::aligned_input_range( pLine, pLine + (width - normLine) ) );
-            auto outIt = std::begin( bs::aligned_output_range( pLine, pLine + (width - normLine) ) );
+            T* pLine = &( matrix[ getIndex( normLine, y, stride ) ] );
+            auto lineIt = std::begin( bs::aligned_input_range( pLine, pLine + (packWidth - normLine) ) );
+            auto outIt = std::begin( bs::aligned_output_range( pLine, pLine + (packWidth - normLine) ) );
             t_pack packScale( -scale );
             for( auto&& val : baseRange ) 
             {
@@ -258,20 +468,22 @@ void simdTransform2( t_dataVector& matrix, t_dataVector& factor )
 	}
 }
 
-void simdTransform3( t_dataVector& matrix, t_dataVector& factor )
+template< typename T >
+void simdTransform3( t_vector<T>& matrix, t_vector<T>& factor )
 {
-    using t_pack = bs::pack<t_dataType>;
+    using t_pack = bs::pack<T>;
     size_t width = factor.size( );
+    size_t stride = matrix.size() / width;
     for( size_t line = 0; line < width - 1; ++line )
     {
         for( size_t y = line + 1; y < width; ++y )
         {
-            t_dataType scale = matrix[ getIndex( line, y, width ) ] / matrix[ getIndex( line, line, width ) ];
+            T scale = matrix[ getIndex( line, y, stride ) ] / matrix[ getIndex( line, line, stride ) ];
             factor[ y ] = bs::fma( -scale, factor[ line ], factor[ y ] );
 
 			size_t normLine = line & ~(static_cast<size_t>(t_pack::static_size - 1));
-            t_dataType* pBase = &( matrix[ getIndex( normLine, line, width ) ] );
-            t_dataType* pLine = &( matrix[ getIndex( normLine, y, width ) ] );
+            T* pBase = &( matrix[ getIndex( normLine, line, stride ) ] );
+            T* pLine = &( matrix[ getIndex( normLine, y, stride ) ] );
 
             bs::transform( pLine, pLine + (width - normLine), pBase, pLine,
             [&scale]( auto&& lhs, auto&& rhs )
@@ -282,11 +494,18 @@ void simdTransform3( t_dataVector& matrix, t_dataVector& factor )
     }
 }
 
-void unrolledSimdTransform( t_dataVector& matrix, t_dataVector& factor )
+template< typename T >
+void unrolledSimdTransform( t_vector<T>& matrix, t_vector<T>& factor )
 {
-	using t_pack = bs::pack<t_dataType>;
+	using t_pack = bs::pack<T>;
 
 	size_t width = factor.size();
+	size_t stride = matrix.size() / width;
+    if( stride % t_pack::static_size )
+    {
+        unalignedSimdTransform( matrix, factor );
+        return;
+    }
     t_pack* packMatrix = reinterpret_cast<t_pack*>( matrix.data( ) );
     for( size_t line = 0; line < width - 1; ++line )
 	{
@@ -295,12 +514,12 @@ void unrolledSimdTransform( t_dataVector& matrix, t_dataVector& factor )
 
 		for( size_t y = line + 1; y < width; ++y )
 		{
-            t_dataType scale = matrix[ getIndex( line, y, width ) ] / matrix[ getIndex( line, line, width ) ];
+            T scale = matrix[ getIndex( line, y, stride ) ] / matrix[ getIndex( line, line, stride ) ];
             factor[ y ] -= scale * factor[ line ];
 
 			size_t x = normLine;
-            t_pack* packLine = &( packMatrix[ getIndex( normLine, y, width ) / t_pack::static_size ] );
-            t_pack* packBase = &( packMatrix[ getIndex( normLine, line, width ) / t_pack::static_size ] );
+            t_pack* packLine = &( packMatrix[ getIndex( normLine, y, stride ) / t_pack::static_size ] );
+            t_pack* packBase = &( packMatrix[ getIndex( normLine, line, stride ) / t_pack::static_size ] );
             t_pack packScale( -scale );
 
             while( x < endWidth )
@@ -323,25 +542,237 @@ void unrolledSimdTransform( t_dataVector& matrix, t_dataVector& factor )
 	}
 }
 
+template< typename T >
+size_t getStride( size_t width )
+{
+	using t_pack = bs::pack<T>;
+    return( (width + t_pack::static_size - 1) & ~(static_cast<size_t>(t_pack::static_size - 1)) );
+}
+
+template< typename T >
+size_t getFactorStride( size_t rhsCount )
+{
+    return( getStride<T>( rhsCount ) );
+}
+
+// Any stride: unaligned loads and stores over the whole packs of each row and a
+// scalar tail, so nothing past the row is ever touched.
+template< typename T >
+void unalignedSimdTransform( t_vector<T>& matrix, t_vector<T>& factor )
+{
+	using t_pack = bs::pack<T>;
+
+	size_t width = factor.size();
+    size_t stride = matrix.size() / width;
+	for( size_t line = 0; line < width - 1; ++line )
+	{
+        const T* pBase = &( matrix[ getIndex( 0, line, stride ) ] );
+		for( size_t y = line + 1; y < width; ++y )
+		{
+            T* pLine = &( matrix[ getIndex( 0, y, stride ) ] );
+            T scale = pLine[ line ] / pBase[ line ];
+            factor[ y ] = bs::fma( -scale, factor[ line ], factor[ y ] );
+
+            t_pack packScale( -scale );
+            size_t x = line;
+            for( ; x + t_pack::static_size <= width; x += t_pack::static_size )
+			{
+                bs::store( bs::fma( packScale, bs::load<t_pack>( pBase + x ), bs::load<t_pack>( pLine + x ) ), pLine + x );
+			}
+            for( ; x < width; ++x )
+            {
+                pLine[ x ] = bs::fma( -scale, pBase[ x ], pLine[ x ] );
+            }
+		}
+	}
+}
+
+template< typename T >
+void simdTransformBlock( t_vector<T>& matrix, t_vector<T>& factors, size_t rhsCount )
+{
+	using t_pack = bs::pack<T>;
+
+    size_t factorStride = getFactorStride<T>( rhsCount );
+	size_t width = factors.size() / factorStride;
+    size_t stride = matrix.size() / width;
+    t_pack* packFactors = reinterpret_cast<t_pack*>( factors.data() );
+	for( size_t line = 0; line < width - 1; ++line )
+	{
+        const T* pBase = &( matrix[ getIndex( 0, line, stride ) ] );
+		for( size_t y = line + 1; y < width; ++y )
+		{
+            T* pLine = &( matrix[ getIndex( 0, y, stride ) ] );
+            T scale = pLine[ line ] / pBase[ line ];
+            t_pack packScale( -scale );
+
+            t_pack* packLine = &( packFactors[ getIndex( 0, y, factorStride ) / t_pack::static_size ] );
+            t_pack* packBase = &( packFactors[ getIndex( 0, line, factorStride ) / t_pack::static_size ] );
+            for( size_t x = 0; x < factorStride; x += t_pack::static_size )
+            {
+                *packLine = bs::fma( packScale, *packBase++, *packLine );
+                packLine++;
+            }
+
+            // Rows are not required to be pack aligned here, whole packs then a scalar tail
+            size_t x = line;
+            for( ; x + t_pack::static_size <= width; x += t_pack::static_size )
+			{
+                bs::store( bs::fma( packScale, bs::load<t_pack>( pBase + x ), bs::load<t_pack>( pLine + x ) ), pLine + x );
+			}
+            for( ; x < width; ++x )
+            {
+                pLine[ x ] = bs::fma( -scale, pBase[ x ], pLine[ x ] );
+            }
+		}
+	}
+}
+
+template< typename T >
+void blockedSimdTransform( t_vector<T>& matrix, t_vector<T>& factor )
+{
+    blockedSimdTransform( matrix, factor, 64 );
+}
+
+// Right-looking blocked elimination. Each panel of blockSize columns is factored
+// touching only its own columns, and the multipliers are kept aside so the
+// trailing submatrix receives all the panel updates in a single GEMM-like pass,
+// tile by tile, while the panel rows are still hot in L1/L2.
+template< typename T >
+void blockedSimdTransform( t_vector<T>& matrix, t_vector<T>& factor, size_t blockSize )
+{
+	using t_pack = bs::pack<T>;
+    const size_t tileWidth = 256;
+
+	size_t width = factor.size();
+	size_t stride = matrix.size() / width;
+    if( stride % t_pack::static_size )
+    {
+        unalignedSimdTransform( matrix, factor );
+        return;
+    }
+    blockSize = (blockSize + t_pack::static_size - 1) & ~(static_cast<size_t>(t_pack::static_size - 1));
+    t_pack* packMatrix = reinterpret_cast<t_pack*>( matrix.data( ) );
+    t_vector<T> multipliers( width * blockSize );
+
+    for( size_t panel = 0; panel < width - 1; panel += blockSize )
+    {
+        size_t panelEnd = std::min( panel + blockSize, width );
+
+        // Panel factorization, only the panel columns are updated
+        for( size_t line = panel; line < panelEnd; ++line )
+        {
+            size_t normLine = line & ~(static_cast<size_t>(t_pack::static_size - 1));
+            for( size_t y = line + 1; y < width; ++y )
+            {
+                T scale = matrix[ getIndex( line, y, stride ) ] / matrix[ getIndex( line, line, stride ) ];
+                factor[ y ] = bs::fma( -scale, factor[ line ], factor[ y ] );
+                multipliers[ getIndex( line - panel, y, blockSize ) ] = scale;
+
+                t_pack* packLine = &( packMatrix[ getIndex( normLine, y, stride ) / t_pack::static_size ] );
+                t_pack* packBase = &( packMatrix[ getIndex( normLine, line, stride ) / t_pack::static_size ] );
+                t_pack packScale( -scale );
+                for( size_t x = normLine; x < panelEnd; x += t_pack::static_size )
+                {
+                    *packLine = bs::fma( packScale, *packBase++, *packLine );
+                    packLine++;
+                }
+            }
+        }
+
+        if( panelEnd == width )
+            break;
+
+        // Triangular update of the panel rows to the right of the panel (U12)
+        for( size_t line = panel; line < panelEnd; ++line )
+        {
+            for( size_t y = line + 1; y < panelEnd; ++y )
+            {
+                t_pack* packLine = &( packMatrix[ getIndex( panelEnd, y, stride ) / t_pack::static_size ] );
+                t_pack* packBase = &( packMatrix[ getIndex( panelEnd, line, stride ) / t_pack::static_size ] );
+                t_pack packScale( -multipliers[ getIndex( line - panel, y, blockSize ) ] );
+                for( size_t x = panelEnd; x < width; x += t_pack::static_size )
+                {
+                    *packLine = bs::fma( packScale, *packBase++, *packLine );
+                    packLine++;
+                }
+            }
+        }
+
+        // Trailing update A22 -= L21 * U12, one column tile of U12 at a time.
+        // Each row keeps four packs in registers while all the panel lines are applied.
+        size_t panelSize = panelEnd - panel;
+        for( size_t column = panelEnd; column < width; column += tileWidth )
+        {
+            size_t columnEnd = std::min( column + tileWidth, width );
+            for( size_t y = panelEnd; y < width; ++y )
+            {
+                const T* pScale = &( multipliers[ getIndex( 0, y, blockSize ) ] );
+
+                size_t x = column;
+                while( x + 4 * t_pack::static_size <= columnEnd )
+                {
+                    t_pack* packLine = &( packMatrix[ getIndex( x, y, stride ) / t_pack::static_size ] );
+                    t_pack acc0 = packLine[ 0 ];
+                    t_pack acc1 = packLine[ 1 ];
+                    t_pack acc2 = packLine[ 2 ];
+                    t_pack acc3 = packLine[ 3 ];
+                    for( size_t j = 0; j < panelSize; ++j )
+                    {
+                        const t_pack* packBase = &( packMatrix[ getIndex( x, panel + j, stride ) / t_pack::static_size ] );
+                        t_pack packScale( -pScale[ j ] );
+                        acc0 = bs::fma( packScale, packBase[ 0 ], acc0 );
+                        acc1 = bs::fma( packScale, packBase[ 1 ], acc1 );
+                        acc2 = bs::fma( packScale, packBase[ 2 ], acc2 );
+                        acc3 = bs::fma( packScale, packBase[ 3 ], acc3 );
+                    }
+                    packLine[ 0 ] = acc0;
+                    packLine[ 1 ] = acc1;
+                    packLine[ 2 ] = acc2;
+                    packLine[ 3 ] = acc3;
+
+                    x += 4 * t_pack::static_size;
+                }
+
+                while( x < columnEnd )
+                {
+                    t_pack* packLine = &( packMatrix[ getIndex( x, y, stride ) / t_pack::static_size ] );
+                    t_pack acc = *packLine;
+                    for( size_t j = 0; j < panelSize; ++j )
+                    {
+                        acc = bs::fma( t_pack( -pScale[ j ] ),
+                                       packMatrix[ getIndex( x, panel + j, stride ) / t_pack::static_size ], acc );
+                    }
+                    *packLine = acc;
+
+                    x += t_pack::static_size;
+                }
+            }
+        }
+    }
+}
+
 #ifdef _OPENMP
-void simdOpenMPTransform( t_dataVector& matrix, t_dataVector& factor )
+namespace
 {
-	using t_pack = bs::pack<t_dataType>;
+template< typename T >
+void simdOpenMPEliminate( t_vector<T>& matrix, t_vector<T>& factor, int stride, int firstLine )
+{
+	using t_pack = bs::pack<T>;
 
 	int width = static_cast<int>(factor.size());
     t_pack* packMatrix = reinterpret_cast<t_pack*>( matrix.data( ) );
-    for( int line = 0; line < width - 1; ++line )
+    for( int line = firstLine; line < width - 1; ++line )
 	{
 		#pragma omp parallel for
 		for( int y = line + 1; y < width; ++y )
 		{
-            t_dataType scale = matrix[ getIndex( line, y, width ) ] / matrix[ getIndex( line, line, width ) ];
+            T scale = matrix[ getIndex( line, y, stride ) ] / matrix[ getIndex( line, line, stride ) ];
             factor[ y ] -= scale * factor[ line ];
 
 			int normLine = line & ~(static_cast<int>(t_pack::static_size - 1));
 
-            t_pack* packLine = &( packMatrix[ getIndex( normLine, y, width ) / t_pack::static_size ] );
-            t_pack* packBase = &( packMatrix[ getIndex( normLine, line, width ) / t_pack::static_size ] );
+            t_pack* packLine = &( packMatrix[ getIndex( normLine, y, stride ) / t_pack::static_size ] );
+            t_pack* packBase = &( packMatrix[ getIndex( normLine, line, stride ) / t_pack::static_size ] );
             t_pack packScale( -scale );
             for( size_t x = normLine; x < width; x += t_pack::static_size )
             {
@@ -350,27 +781,108 @@ void simdOpenMPTransform( t_dataVector& matrix, t_dataVector& factor )
         }
 	}
 }
+} // namespace
+
+template< typename T >
+void simdOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor )
+{
+	using t_pack = bs::pack<T>;
+
+	int width = static_cast<int>(factor.size());
+	int stride = static_cast<int>( matrix.size() ) / width;
+    if( stride % static_cast<int>( t_pack::static_size ) )
+    {
+        unalignedSimdOpenMPTransform( matrix, factor );
+        return;
+    }
+    simdOpenMPEliminate( matrix, factor, stride, 0 );
+}
 
-void unrolledSimdOpenMPTransform( t_dataVector& matrix, t_dataVector& factor )
+template< typename T >
+void simdOpenMPTransform( const t_vector<T>& source, t_vector<T>& matrix, t_vector<T>& factor )
 {
-	using t_pack = bs::pack<t_dataType>;
+	using t_pack = bs::pack<T>;
 
 	int width = static_cast<int>(factor.size());
+	int stride = static_cast<int>( source.size() ) / width;
+    matrix.resize( source.size() );
+    if( stride % static_cast<int>( t_pack::static_size ) )
+    {
+        std::copy( source.begin(), source.end(), matrix.begin() );
+        unalignedSimdOpenMPTransform( matrix, factor );
+        return;
+    }
+
+    #pragma omp parallel for
+    for( int y = 0; y < width; ++y )
+    {
+        copyFirstLine( source, matrix, factor, y, stride );
+    }
+    simdOpenMPEliminate( matrix, factor, stride, 1 );
+}
+
+template< typename T >
+void scaledSimdOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor )
+{
+	using t_pack = bs::pack<T>;
+
+	int width = static_cast<int>(factor.size());
+	int stride = static_cast<int>( matrix.size() ) / width;
+    if( stride % static_cast<int>( t_pack::static_size ) )
+    {
+        unalignedSimdOpenMPTransform( matrix, factor );
+        return;
+    }
+    t_vector<T> scales( width );
+    t_pack* packMatrix = reinterpret_cast<t_pack*>( matrix.data( ) );
+    for( int line = 0; line < width - 1; ++line )
+	{
+        // Serial, one pass over the column, so the parallel rows never divide
+        computeMultipliers( matrix, factor, line, stride, scales );
+
+		int normLine = line & ~(static_cast<int>(t_pack::static_size - 1));
+        const t_pack* packBase = &( packMatrix[ getIndex( normLine, line, stride ) / t_pack::static_size ] );
+
+		#pragma omp parallel for
+		for( int y = line + 1; y < width; ++y )
+		{
+            t_pack* packLine = &( packMatrix[ getIndex( normLine, y, stride ) / t_pack::static_size ] );
+            t_pack packScale( -scales[ y - line - 1 ] );
+            for( int x = normLine, i = 0; x < width; x += t_pack::static_size, ++i )
+            {
+                packLine[ i ] = bs::fma( packScale, packBase[ i ], packLine[ i ] );
+            }
+        }
+	}
+}
+
+template< typename T >
+void unrolledSimdOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor )
+{
+	using t_pack = bs::pack<T>;
+
+	int width = static_cast<int>(factor.size());
+	int stride = static_cast<int>( matrix.size() ) / width;
+    if( stride % static_cast<int>( t_pack::static_size ) )
+    {
+        unalignedSimdOpenMPTransform( matrix, factor );
+        return;
+    }
     t_pack* packMatrix = reinterpret_cast<t_pack*>( matrix.data( ) );
     for( int line = 0; line < width - 1; ++line )
 	{
 		int normLine = line & ~(4*t_pack::static_size - 1);
-		int endWidth = (width - normLine) & ~(4*t_pack::static_size - 1);
+		int endWidth = normLine + ((width - normLine) & ~(4*t_pack::static_size - 1));
 
 		#pragma omp parallel for
 		for( int y = line + 1; y < width; ++y )
 		{
-            t_dataType scale = matrix[ getIndex( line, y, width ) ] / matrix[ getIndex( line, line, width ) ];
+            T scale = matrix[ getIndex( line, y, stride ) ] / matrix[ getIndex( line, line, stride ) ];
             factor[ y ] -= scale * factor[ line ];
 
 			int x = normLine;
-            t_pack* packLine = &( packMatrix[ getIndex( normLine, y, width ) / t_pack::static_size ] );
-            t_pack* packBase = &( packMatrix[ getIndex( normLine, line, width ) / t_pack::static_size ] );
+            t_pack* packLine = &( packMatrix[ getIndex( normLine, y, stride ) / t_pack::static_size ] );
+            t_pack* packBase = &( packMatrix[ getIndex( normLine, line, stride ) / t_pack::static_size ] );
             t_pack packScale( -scale );
 
             while( x < endWidth )
@@ -391,29 +903,104 @@ void unrolledSimdOpenMPTransform( t_dataVector& matrix, t_dataVector& factor )
         }
 	}
 }
+
+template< typename T >
+void unalignedSimdOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor )
+{
+	using t_pack = bs::pack<T>;
+
+	int width = static_cast<int>(factor.size());
+    int stride = static_cast<int>( matrix.size() ) / width;
+    for( int line = 0; line < width - 1; ++line )
+	{
+        const T* pBase = &( matrix[ getIndex( 0, line, stride ) ] );
+
+		#pragma omp parallel for
+		for( int y = line + 1; y < width; ++y )
+		{
+            T* pLine = &( matrix[ getIndex( 0, y, stride ) ] );
+            T scale = pLine[ line ] / pBase[ line ];
+            factor[ y ] -= scale * factor[ line ];
+
+            t_pack packScale( -scale );
+            int x = line;
+            for( ; x + static_cast<int>( t_pack::static_size ) <= width; x += t_pack::static_size )
+            {
+                bs::store( bs::fma( packScale, bs::load<t_pack>( pBase + x ), bs::load<t_pack>( pLine + x ) ), pLine + x );
+            }
+            for( ; x < width; ++x )
+            {
+                pLine[ x ] -= scale * pBase[ x ];
+            }
+        }
+	}
+}
+#endif // _OPENMP
+
+#define INSTANTIATE_TRANSFORMS( T ) \
+template void simpleTransform( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void unrolledTransform( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void vectorizedTransform( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void simdTransform( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void simdTransform( const t_vector<T>& source, t_vector<T>& matrix, t_vector<T>& factor ); \
+template void scaledSimdTransform( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void streamSimdTransform( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void streamSimdTransform( t_vector<T>& matrix, t_vector<T>& factor, size_t prefetchLines ); \
+template void simdTransform2( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void simdTransform3( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void unrolledSimdTransform( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void unalignedSimdTransform( t_vector<T>& matrix, t_vector<T>& factor ); \
+template size_t getStride<T>( size_t width ); \
+template size_t getFactorStride<T>( size_t rhsCount ); \
+template void simdTransformBlock( t_vector<T>& matrix, t_vector<T>& factors, size_t rhsCount ); \
+template void blockedSimdTransform( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void blockedSimdTransform( t_vector<T>& matrix, t_vector<T>& factor, size_t blockSize );
+
+INSTANTIATE_TRANSFORMS( float )
+INSTANTIATE_TRANSFORMS( double )
+
+#ifdef _OPENMP
+#define INSTANTIATE_OPENMP_TRANSFORMS( T ) \
+template void openMPTransform( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void unrolledOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void vectorizedOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void simdOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void simdOpenMPTransform( const t_vector<T>& source, t_vector<T>& matrix, t_vector<T>& factor ); \
+template void scaledSimdOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void unrolledSimdOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void unalignedSimdOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor );
+
+INSTANTIATE_OPENMP_TRANSFORMS( float )
+INSTANTIATE_OPENMP_TRANSFORMS( double )
 #endif // _OPENMP
 
 #ifdef BUILD_INTRINSICS_TRANSFORMS
 void intrinsicsTransformFloat( t_dataVector& matrix, t_dataVector& factor )
 {
 	size_t width = factor.size();
+	size_t stride = matrix.size() / width;
+    if( stride % 4 )
+    {
+        unalignedSimdTransform( matrix, factor );
+        return;
+    }
 	for( size_t line = 0; line < width - 1; ++line )
 	{
 		size_t normLine = line & ~(3);
 
 		for( size_t y = line + 1; y < width; ++y )
 		{
-			float scale = matrix[ getIndex( line, y, width ) ] / matrix[ getIndex( line, line, width ) ];
+			float scale = matrix[ getIndex( line, y, stride ) ] / matrix[ getIndex( line, line, stride ) ];
 			 __m128 xmmScale = _mm_set1_ps( scale );
 
 			factor[ y ] -= scale * factor[ line ];
 
 			for( size_t x = normLine; x < width; x += 4 )
 			{
-				_mm_store_ps( matrix.data() + getIndex( x, y, width ),
-							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, width ) ),
+				_mm_store_ps( matrix.data() + getIndex( x, y, stride ),
+							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, stride ) ),
 										  _mm_mul_ps( xmmScale,
-													  _mm_load_ps( matrix.data() + getIndex( x, line, width ) ) ) ) );
+													  _mm_load_ps( matrix.data() + getIndex( x, line, stride ) ) ) ) );
 			}
 		}
 	}
@@ -422,6 +1009,12 @@ void intrinsicsTransformFloat( t_dataVector& matrix, t_dataVector& factor )
 void unrolledIntrinsicsTransformFloat( t_dataVector& matrix, t_dataVector& factor )
 {
 	size_t width = factor.size();
+	size_t stride = matrix.size() / width;
+    if( stride % 4 )
+    {
+        unalignedSimdTransform( matrix, factor );
+        return;
+    }
 	for( size_t line = 0; line < width - 1; ++line )
 	{
 		size_t normLine = line & ~(3);
@@ -429,7 +1022,7 @@ void unrolledIntrinsicsTransformFloat( t_dataVector& matrix, t_dataVector& facto
 
 		for( size_t y = line + 1; y < width; ++y )
 		{
-			float scale = matrix[ getIndex( line, y, width ) ] / matrix[ getIndex( line, line, width ) ];
+			float scale = matrix[ getIndex( line, y, stride ) ] / matrix[ getIndex( line, line, stride ) ];
 			 __m128 xmmScale = _mm_set1_ps( scale );
 
 			factor[ y ] -= scale * factor[ line ];
@@ -437,34 +1030,34 @@ void unrolledIntrinsicsTransformFloat( t_dataVector& matrix, t_dataVector& facto
 			size_t x = normLine;
 			while( x < endWidth )
 			{
-				_mm_store_ps( matrix.data() + getIndex( x, y, width ),
-							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, width ) ),
+				_mm_store_ps( matrix.data() + getIndex( x, y, stride ),
+							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, stride ) ),
 										  _mm_mul_ps( xmmScale,
-													  _mm_load_ps( matrix.data() + getIndex( x, line, width ) ) ) ) );
+													  _mm_load_ps( matrix.data() + getIndex( x, line, stride ) ) ) ) );
 				x += 4;
-				_mm_store_ps( matrix.data() + getIndex( x, y, width ),
-							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, width ) ),
+				_mm_store_ps( matrix.data() + getIndex( x, y, stride ),
+							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, stride ) ),
 										  _mm_mul_ps( xmmScale,
-													  _mm_load_ps( matrix.data() + getIndex( x, line, width ) ) ) ) );
+													  _mm_load_ps( matrix.data() + getIndex( x, line, stride ) ) ) ) );
 				x += 4;
-				_mm_store_ps( matrix.data() + getIndex( x, y, width ),
-							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, width ) ),
+				_mm_store_ps( matrix.data() + getIndex( x, y, stride ),
+							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, stride ) ),
 										  _mm_mul_ps( xmmScale,
-													  _mm_load_ps( matrix.data() + getIndex( x, line, width ) ) ) ) );
+													  _mm_load_ps( matrix.data() + getIndex( x, line, stride ) ) ) ) );
 				x += 4;
-				_mm_store_ps( matrix.data() + getIndex( x, y, width ),
-							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, width ) ),
+				_mm_store_ps( matrix.data() + getIndex( x, y, stride ),
+							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, stride ) ),
 										  _mm_mul_ps( xmmScale,
-													  _mm_load_ps( matrix.data() + getIndex( x, line, width ) ) ) ) );
+													  _mm_load_ps( matrix.data() + getIndex( x, line, stride ) ) ) ) );
 				x += 4;
 			}
 
 			while( x < width )
 			{
-				_mm_store_ps( matrix.data() + getIndex( x, y, width ),
-							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, width ) ),
+				_mm_store_ps( matrix.data() + getIndex( x, y, stride ),
+							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, stride ) ),
 										  _mm_mul_ps( xmmScale,
-													  _mm_load_ps( matrix.data() + getIndex( x, line, width ) ) ) ) );
+													  _mm_load_ps( matrix.data() + getIndex( x, line, stride ) ) ) ) );
 				x += 4;
 			}
 		}
@@ -475,6 +1068,12 @@ void unrolledIntrinsicsTransformFloat( t_dataVector& matrix, t_dataVector& facto
 void intrinsicsOpenMPTransformFloat( t_dataVector& matrix, t_dataVector& factor )
 {
 	int width = static_cast<int>( factor.size() );
+	int stride = static_cast<int>( matrix.size() ) / width;
+    if( stride % 4 )
+    {
+        unalignedSimdOpenMPTransform( matrix, factor );
+        return;
+    }
 	for( int line = 0; line < width - 1; ++line )
 	{
 		int normLine = line & ~(3);
@@ -482,17 +1081,17 @@ void intrinsicsOpenMPTransformFloat( t_dataVector& matrix, t_dataVector& factor
 		#pragma omp parallel for schedule(static)
 		for( int y = line + 1; y < width; ++y )
 		{
-			float scale = matrix[ getIndex( line, y, width ) ] / matrix[ getIndex( line, line, width ) ];
+			float scale = matrix[ getIndex( line, y, stride ) ] / matrix[ getIndex( line, line, stride ) ];
 			 __m128 xmmScale = _mm_set1_ps( scale );
 
 			factor[ y ] -= scale * factor[ line ];
 
 			for( int x = normLine; x < width; x += 4 )
 			{
-				_mm_store_ps( matrix.data() + getIndex( x, y, width ),
-							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, width ) ),
+				_mm_store_ps( matrix.data() + getIndex( x, y, stride ),
+							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, stride ) ),
 										  _mm_mul_ps( xmmScale,
-													  _mm_load_ps( matrix.data() + getIndex( x, line, width ) ) ) ) );
+													  _mm_load_ps( matrix.data() + getIndex( x, line, stride ) ) ) ) );
 			}
 		}
 	}
@@ -501,6 +1100,12 @@ void intrinsicsOpenMPTransformFloat( t_dataVector& matrix, t_dataVector& factor
 void unrolledIntrinsicsOpenMPTransformFloat( t_dataVector& matrix, t_dataVector& factor )
 {
 	int width = static_cast<int>( factor.size() );
+	int stride = static_cast<int>( matrix.size() ) / width;
+    if( stride % 4 )
+    {
+        unalignedSimdOpenMPTransform( matrix, factor );
+        return;
+    }
 	for( int line = 0; line < width - 1; ++line )
 	{
 		int normLine = line & ~(3);
@@ -509,7 +1114,7 @@ void unrolledIntrinsicsOpenMPTransformFloat( t_dataVector& matrix, t_dataVector&
 		#pragma omp parallel for schedule(static)
 		for( int y = line + 1; y < width; ++y )
 		{
-			float scale = matrix[ getIndex( line, y, width ) ] / matrix[ getIndex( line, line, width ) ];
+			float scale = matrix[ getIndex( line, y, stride ) ] / matrix[ getIndex( line, line, stride ) ];
 			 __m128 xmmScale = _mm_set1_ps( scale );
 
 			factor[ y ] -= scale * factor[ line ];
@@ -517,34 +1122,34 @@ void unrolledIntrinsicsOpenMPTransformFloat( t_dataVector& matrix, t_dataVector&
 			int x = normLine;
 			while( x < endWidth )
 			{
-				_mm_store_ps( matrix.data() + getIndex( x, y, width ),
-							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, width ) ),
+				_mm_store_ps( matrix.data() + getIndex( x, y, stride ),
+							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, stride ) ),
 										  _mm_mul_ps( xmmScale,
-													  _mm_load_ps( matrix.data() + getIndex( x, line, width ) ) ) ) );
+													  _mm_load_ps( matrix.data() + getIndex( x, line, stride ) ) ) ) );
 				x += 4;
-				_mm_store_ps( matrix.data() + getIndex( x, y, width ),
-							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, width ) ),
+				_mm_store_ps( matrix.data() + getIndex( x, y, stride ),
+							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, stride ) ),
 										  _mm_mul_ps( xmmScale,
-													  _mm_load_ps( matrix.data() + getIndex( x, line, width ) ) ) ) );
+													  _mm_load_ps( matrix.data() + getIndex( x, line, stride ) ) ) ) );
 				x += 4;
-				_mm_store_ps( matrix.data() + getIndex( x, y, width ),
-							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, width ) ),
+				_mm_store_ps( matrix.data() + getIndex( x, y, stride ),
+							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, stride ) ),
 										  _mm_mul_ps( xmmScale,
-													  _mm_load_ps( matrix.data() + getIndex( x, line, width ) ) ) ) );
+													  _mm_load_ps( matrix.data() + getIndex( x, line, stride ) ) ) ) );
 				x += 4;
-				_mm_store_ps( matrix.data() + getIndex( x, y, width ),
-							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, width ) ),
+				_mm_store_ps( matrix.data() + getIndex( x, y, stride ),
+							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, stride ) ),
 										  _mm_mul_ps( xmmScale,
-													  _mm_load_ps( matrix.data() + getIndex( x, line, width ) ) ) ) );
+													  _mm_load_ps( matrix.data() + getIndex( x, line, stride ) ) ) ) );
 				x += 4;
 			}
 
 			while( x < width )
 			{
-				_mm_store_ps( matrix.data() + getIndex( x, y, width ),
-							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, width ) ),
+				_mm_store_ps( matrix.data() + getIndex( x, y, stride ),
+							  _mm_sub_ps( _mm_load_ps( matrix.data() + getIndex( x, y, stride ) ),
 										  _mm_mul_ps( xmmScale,
-													  _mm_load_ps( matrix.data() + getIndex( x, line, width ) ) ) ) );
+													  _mm_load_ps( matrix.data() + getIndex( x, line, stride ) ) ) ) );
 				x += 4;
 			}
 		}
@@ -24,19 +24,125 @@
 #define __BOOST_SIMD_TEST__
 
 #include <vector>
-#include <boost/simd/memory/allocator.hpp>
+#include "arenaAllocator.h"
 
 #define BUILD_INTRINSICS_TRANSFORMS 1
+// Task dependencies need OpenMP 4.0, so OpenMP 2.0 (MSVC) builds without the task kernel
+#if defined( _OPENMP ) && _OPENMP >= 201307
+#define BUILD_TASK_TRANSFORMS 1
+#endif
+template< typename T >
+using t_vector = std::vector<T, ArenaAllocator<T>>;
 using t_dataType = float;
-using t_dataVector = std::vector<t_dataType, boost::simd::allocator<t_dataType>>;
+using t_dataVector = t_vector<t_dataType>;
+using t_indexVector = std::vector<size_t>;
 
-void simpleTransform( t_dataVector& matrix, t_dataVector& factor );
-void unrolledTransform( t_dataVector& matrix, t_dataVector& factor );
-void vectorizedTransform(t_dataVector& matrix, t_dataVector& factor);
-void simdTransform( t_dataVector& matrix, t_dataVector& factor );
-void simdTransform2( t_dataVector& matrix, t_dataVector& factor );
-void simdTransform3( t_dataVector& matrix, t_dataVector& factor );
-void unrolledSimdTransform( t_dataVector& matrix, t_dataVector& factor );
+inline size_t getIndex( size_t x, size_t y, size_t width )
+{
+	return( y * width + x );
+}
+
+// Matrices are row major, width = factor.size() and the row stride (leading dimension)
+// is matrix.size() / width. getStride() pads rows to a whole number of packs, which
+// keeps every row aligned for the fast paths, which may overwrite the padding columns;
+// any other stride is still handled, via unalignedSimdTransform, without touching
+// memory past the rows.
+template< typename T > size_t getStride( size_t width );
+
+// Generic transforms, built for float and double
+template< typename T > void simpleTransform( t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void unrolledTransform( t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void vectorizedTransform( t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void simdTransform( t_vector<T>& matrix, t_vector<T>& factor );
+// Out of place: source is left as it is and matrix (resized to it when needed, reuse it
+// to skip the zero fill) receives the transform. The copy is the first pivot line's
+// update, so no separate pass writes matrix. factor is still transformed in place.
+template< typename T > void simdTransform( const t_vector<T>& source, t_vector<T>& matrix, t_vector<T>& factor );
+// Multipliers of each line computed up front, one reciprocal and packed multiplies
+template< typename T > void scaledSimdTransform( t_vector<T>& matrix, t_vector<T>& factor );
+
+// Fully unrolled kernels for the widths 8, 16, 32, 64 and 128 (those that are a whole
+// number of packs), any other width or a padded stride runs simdTransform
+template< typename T > bool hasFixedSimdKernel( size_t width );
+template< typename T > void fixedSimdTransform( t_vector<T>& matrix, t_vector<T>& factor );
+
+// Non-temporal row stores with software prefetch, for matrices past the last level
+// cache. The two argument form streams from thresholdBytes on and runs simdTransform
+// below it, with the settings of setStreamTuning (default 8 lines, 32 MB).
+void setStreamTuning( size_t prefetchLines, size_t thresholdBytes );
+template< typename T > void streamSimdTransform( t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void streamSimdTransform( t_vector<T>& matrix, t_vector<T>& factor, size_t prefetchLines );
+template< typename T > void simdTransform2( t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void simdTransform3( t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void unrolledSimdTransform( t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void unalignedSimdTransform( t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void blockedSimdTransform( t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void blockedSimdTransform( t_vector<T>& matrix, t_vector<T>& factor, size_t blockSize );
+
+// Right-hand side blocks: row y holds rhsCount values padded to getFactorStride( rhsCount ),
+// so all of them are updated with packed FMAs in the same pass over the matrix.
+template< typename T > size_t getFactorStride( size_t rhsCount );
+template< typename T > void simdTransformBlock( t_vector<T>& matrix, t_vector<T>& factors, size_t rhsCount );
+
+// Solves the upper triangular system left by a transform, factor receives the solution.
+template< typename T > void backSubstitution( const t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void backSubstitutionBlock( const t_vector<T>& matrix, t_vector<T>& factors, size_t rhsCount );
+
+// Partial pivoting. Row swaps are tracked in a permutation and applied once at the end.
+template< typename T > void pivotSimdTransform( t_vector<T>& matrix, t_vector<T>& factor );
+
+// LU factorization with partial pivoting, L multipliers (unit diagonal) stored in place
+// below U. permutation.size() is the matrix width; on return row i of the factorization
+// comes from row permutation[i] of the input. luSolve overwrites factor with the solution.
+template< typename T > void luFactor( t_vector<T>& matrix, t_indexVector& permutation );
+template< typename T > void luSolve( const t_vector<T>& lu, const t_indexVector& permutation, t_vector<T>& factor );
+template< typename T > void luSolveBlock( const t_vector<T>& lu, const t_indexVector& permutation, t_vector<T>& factors, size_t rhsCount );
+
+// Updates a luFactor result in place to the factorization of A + X Y^T in O(rank n^2),
+// instead of factoring again. x and y hold rank vectors of width values each, vector r
+// from r * width. The permutation is kept, no pivoting happens during the update, so
+// the changed matrix must still be safe to eliminate in that row order.
+// luReplaceRow is the rank 1 update that turns input row row into values.
+template< typename T > void luUpdate( t_vector<T>& lu, const t_indexVector& permutation, const t_vector<T>& x, const t_vector<T>& y, size_t rank );
+template< typename T > void luReplaceRow( t_vector<T>& lu, const t_indexVector& permutation, size_t row, const t_vector<T>& values );
+
+// Cholesky for symmetric positive definite systems, A = L L^T. Only the lower triangle is
+// read and written, about half the flops and traffic of simdTransform. choleskyFactor
+// leaves L there and returns false for a matrix that is not positive definite;
+// choleskySolve overwrites factor with the solution. choleskySimdTransform follows the
+// transform contract: L^T in the upper triangle and factor = L^-1 factor, and throws
+// std::domain_error for a matrix that is not positive definite.
+template< typename T > bool choleskyFactor( t_vector<T>& matrix, size_t width );
+template< typename T > void choleskySolve( const t_vector<T>& l, t_vector<T>& factor );
+template< typename T > void choleskySimdTransform( t_vector<T>& matrix, t_vector<T>& factor );
+
+// Factors in float with the SIMD kernels and refines the solution in double until
+// it reaches double accuracy or stops improving. Returns the float solves used.
+size_t mixedPrecisionSolve( const t_vector<double>& matrix, const t_vector<double>& factor,
+                            t_vector<double>& solution, size_t maxIterations = 10 );
+
+// Batches of small systems interleaved SoA style, each pack lane holds a different system.
+// size is the element count of one system (width * width for matrices, width for factors).
+template< typename T > size_t getBatchLanes();
+template< typename T > size_t getBatchSize( size_t count, size_t size );
+template< typename T > void interleaveBatch( const t_vector<T>& source, t_vector<T>& batch, size_t size );
+template< typename T > void deinterleaveBatch( const t_vector<T>& batch, t_vector<T>& destination, size_t size );
+template< typename T > void batchedSimdTransform( t_vector<T>& matrices, t_vector<T>& factors, size_t width );
+
+// Banded systems, nonzeros at most lower diagonals below and upper above the main one.
+// Elimination without pivoting keeps the band, so the banded storage holds only it: row y
+// starts at column getBandOffset( y, lower ) and is getBandStride( lower, upper ) long.
+template< typename T > void getBandwidth( const t_vector<T>& matrix, size_t width, size_t& lower, size_t& upper );
+template< typename T > size_t getBandStride( size_t lower, size_t upper );
+template< typename T > size_t getBandOffset( size_t y, size_t lower );
+template< typename T > void toBand( const t_vector<T>& matrix, t_vector<T>& band, size_t width, size_t lower, size_t upper );
+template< typename T > void fromBand( const t_vector<T>& band, t_vector<T>& matrix, size_t width, size_t lower, size_t upper );
+template< typename T > void bandedSimdTransform( t_vector<T>& band, t_vector<T>& factor, size_t lower, size_t upper );
+template< typename T > void bandedBackSubstitution( const t_vector<T>& band, t_vector<T>& factor, size_t lower, size_t upper );
+
+// Block sparse systems in dense storage, all zero packs of the pivot row and rows with a
+// zero multiplier are skipped.
+template< typename T > void sparseSimdTransform( t_vector<T>& matrix, t_vector<T>& factor );
 
 #ifdef BUILD_INTRINSICS_TRANSFORMS
 void intrinsicsTransformFloat( t_dataVector& matrix, t_dataVector& factor );
@@ -44,11 +150,18 @@ void unrolledIntrinsicsTransformFloat( t_dataVector& matrix, t_dataVector& facto
 #endif // BUILD_INTRINSICS_TRANSFORMS
 
 #ifdef _OPENMP
-void openMPTransform( t_dataVector& matrix, t_dataVector& factor );
-void unrolledOpenMPTransform( t_dataVector& matrix, t_dataVector& factor );
-void vectorizedOpenMPTransform(t_dataVector& matrix, t_dataVector& factor);
-void simdOpenMPTransform( t_dataVector& matrix, t_dataVector& factor );
-void unrolledSimdOpenMPTransform( t_dataVector& matrix, t_dataVector& factor );
+template< typename T > void openMPTransform( t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void unrolledOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void vectorizedOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void simdOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void simdOpenMPTransform( const t_vector<T>& source, t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void scaledSimdOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void unrolledSimdOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void unalignedSimdOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor );
+#ifdef BUILD_TASK_TRANSFORMS
+template< typename T > void taskOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor );
+template< typename T > void taskOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor, size_t tileSize );
+#endif // BUILD_TASK_TRANSFORMS
 #ifdef BUILD_INTRINSICS_TRANSFORMS
 void intrinsicsOpenMPTransformFloat( t_dataVector& matrix, t_dataVector& factor );
 void unrolledIntrinsicsOpenMPTransformFloat( t_dataVector& matrix, t_dataVector& factor );
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "cpuDispatch.h"
+
+#define DECLARE_DISPATCH_KERNELS( isa ) \
+namespace isa \
+{ \
+void simdTransform( t_dataType* matrix, t_dataType* factor, size_t width, size_t stride ); \
+void intrinsicsTransform( t_dataType* matrix, t_dataType* factor, size_t width, size_t stride ); \
+}
+
+DECLARE_DISPATCH_KERNELS( isa_sse )
+DECLARE_DISPATCH_KERNELS( isa_avx2 )
+DECLARE_DISPATCH_KERNELS( isa_avx512 )
+
+namespace
+{
+using t_kernel = void (*)( t_dataType* matrix, t_dataType* factor, size_t width, size_t stride );
+
+struct DispatchTable
+{
+    t_kernel simdTransform_;
+    t_kernel intrinsicsTransform_;
+};
+
+#ifdef _MSC_VER
+bool hasOsAvxSupport( unsigned long long mask )
+{
+    int info[ 4 ];
+    __cpuid( info, 1 );
+    bool osxsave = (info[ 2 ] & (1 << 27)) != 0;
+    return( osxsave && (_xgetbv( 0 ) & mask) == mask );
+}
+
+bool hasAvx2()
+{
+    int info[ 4 ];
+    __cpuid( info, 1 );
+    bool fma = (info[ 2 ] & (1 << 12)) != 0;
+    __cpuidex( info, 7, 0 );
+    return( fma && (info[ 1 ] & (1 << 5)) != 0 && hasOsAvxSupport( 0x6 ) );
+}
+
+// dispatchAvx512.cpp is built for Skylake-AVX512: F, DQ, BW and VL
+bool hasAvx512()
+{
+    int info[ 4 ];
+    __cpuidex( info, 7, 0 );
+    const unsigned features = (1u << 16) | (1u << 17) | (1u << 30) | (1u << 31);
+    return( (static_cast<unsigned>( info[ 1 ] ) & features) == features && hasOsAvxSupport( 0xe6 ) );
+}
+#else
+bool hasAvx2()
+{
+    return( __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" ) );
+}
+
+// dispatchAvx512.cpp is built for Skylake-AVX512: F, DQ, BW and VL
+bool hasAvx512()
+{
+    return( __builtin_cpu_supports( "avx512f" ) && __builtin_cpu_supports( "avx512dq" )
+         && __builtin_cpu_supports( "avx512bw" ) && __builtin_cpu_supports( "avx512vl" ) );
+}
+#endif
+
+const DispatchTable& getDispatchTable()
+{
+    static const DispatchTable table = []()
+    {
+        switch( detectIsa() )
+        {
+        case t_isa::avx512: return( DispatchTable{ &isa_avx512::simdTransform, &isa_avx512::intrinsicsTransform } );
+        case t_isa::avx2:   return( DispatchTable{ &isa_avx2::simdTransform, &isa_avx2::intrinsicsTransform } );
+        default:            return( DispatchTable{ &isa_sse::simdTransform, &isa_sse::intrinsicsTransform } );
+        }
+    }();
+    return( table );
+}
+} // namespace
+
+t_isa detectIsa()
+{
+    if( hasAvx512() )
+        return( t_isa::avx512 );
+    if( hasAvx2() )
+        return( t_isa::avx2 );
+    return( t_isa::sse );
+}
+
+const char* getIsaName( t_isa isa )
+{
+    switch( isa )
+    {
+    case t_isa::avx512: return( "AVX-512" );
+    case t_isa::avx2:   return( "AVX2" );
+    default:            return( "SSE4.2" );
+    }
+}
+
+void dispatchSimdTransform( t_dataVector& matrix, t_dataVector& factor )
+{
+    getDispatchTable().simdTransform_( matrix.data(), factor.data(), factor.size(), matrix.size() / factor.size() );
+}
+
+void dispatchSimdTransform( t_dataType* matrix, t_dataType* factor, size_t width, size_t stride )
+{
+    getDispatchTable().simdTransform_( matrix, factor, width, stride );
+}
+
+void dispatchIntrinsicsTransform( t_dataVector& matrix, t_dataVector& factor )
+{
+    getDispatchTable().intrinsicsTransform_( matrix.data(), factor.data(), factor.size(), matrix.size() / factor.size() );
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#ifndef __CPU_DISPATCH__
+#define __CPU_DISPATCH__
+
+#include "boostSimd.h"
+
+// Instruction sets with a kernel build, from the narrowest to the widest
+enum class t_isa { sse, avx2, avx512 };
+
+t_isa detectIsa();
+const char* getIsaName( t_isa isa );
+
+// Run the kernel built for the widest instruction set of this host, selected at startup
+void dispatchSimdTransform( t_dataVector& matrix, t_dataVector& factor );
+void dispatchIntrinsicsTransform( t_dataVector& matrix, t_dataVector& factor );
+
+// Same kernel on memory the caller owns, e.g. a mapped file, rows stride elements apart
+void dispatchSimdTransform( t_dataType* matrix, t_dataType* factor, size_t width, size_t stride );
+
+#endif // __CPU_DISPATCH__
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+// Kernels built once per instruction set. Each dispatch*.cpp defines
+// DISPATCH_ISA (namespace) and DISPATCH_PACK_SIZE and includes this file with
+// its own target flags. Only raw pointers cross this boundary, and nothing here
+// may instantiate a bs:: or std:: template: those are weak symbols shared with
+// the generic objects, and the linker would keep one copy built for any of the
+// instruction sets. Packs come from the Pack struct below, which has internal
+// linkage. Rows are stride elements apart and only the first width columns are
+// touched, whole packs first and then a scalar tail.
+#include <immintrin.h>
+
+#include "boostSimd.h"
+
+namespace
+{
+// DISPATCH_PACK_SIZE floats on this file's instruction set
+#if DISPATCH_PACK_SIZE == 16
+struct Pack
+{
+    static const size_t static_size = 16;
+    __m512 value_;
+
+    static Pack set( float value ) { return( Pack{ _mm512_set1_ps( value ) } ); }
+    static Pack load( const float* pointer ) { return( Pack{ _mm512_loadu_ps( pointer ) } ); }
+    void store( float* pointer ) const { _mm512_storeu_ps( pointer, value_ ); }
+    // this - scale * base
+    Pack subtractProduct( const Pack& scale, const Pack& base ) const { return( Pack{ _mm512_fnmadd_ps( scale.value_, base.value_, value_ ) } ); }
+};
+#elif DISPATCH_PACK_SIZE == 8
+struct Pack
+{
+    static const size_t static_size = 8;
+    __m256 value_;
+
+    static Pack set( float value ) { return( Pack{ _mm256_set1_ps( value ) } ); }
+    static Pack load( const float* pointer ) { return( Pack{ _mm256_loadu_ps( pointer ) } ); }
+    void store( float* pointer ) const { _mm256_storeu_ps( pointer, value_ ); }
+    Pack subtractProduct( const Pack& scale, const Pack& base ) const { return( Pack{ _mm256_fnmadd_ps( scale.value_, base.value_, value_ ) } ); }
+};
+#else
+struct Pack
+{
+    static const size_t static_size = 4;
+    __m128 value_;
+
+    static Pack set( float value ) { return( Pack{ _mm_set1_ps( value ) } ); }
+    static Pack load( const float* pointer ) { return( Pack{ _mm_loadu_ps( pointer ) } ); }
+    void store( float* pointer ) const { _mm_storeu_ps( pointer, value_ ); }
+    Pack subtractProduct( const Pack& scale, const Pack& base ) const { return( Pack{ _mm_sub_ps( value_, _mm_mul_ps( scale.value_, base.value_ ) ) } ); }
+};
+#endif
+} // namespace
+
+namespace DISPATCH_ISA
+{
+void simdTransform( t_dataType* matrix, t_dataType* factor, size_t width, size_t stride )
+{
+	using t_pack = Pack;
+
+	for( size_t line = 0; line < width - 1; ++line )
+	{
+        const t_dataType* pBase = matrix + line * stride;
+		for( size_t y = line + 1; y < width; ++y )
+		{
+            t_dataType* pLine = matrix + y * stride;
+            t_dataType scale = pLine[ line ] / pBase[ line ];
+            factor[ y ] -= scale * factor[ line ];
+
+            t_pack packScale = t_pack::set( scale );
+            size_t x = line;
+            for( ; x + t_pack::static_size <= width; x += t_pack::static_size )
+			{
+                t_pack::load( pLine + x ).subtractProduct( packScale, t_pack::load( pBase + x ) ).store( pLine + x );
+			}
+            for( ; x < width; ++x )
+            {
+                pLine[ x ] -= scale * pBase[ x ];
+            }
+		}
+	}
+}
+
+#if defined( __AVX512F__ )
+void intrinsicsTransform( t_dataType* matrix, t_dataType* factor, size_t width, size_t stride )
+{
+	for( size_t line = 0; line < width - 1; ++line )
+	{
+        const float* pBase = matrix + line * stride;
+
+		for( size_t y = line + 1; y < width; ++y )
+		{
+            float* pLine = matrix + y * stride;
+			float scale = pLine[ line ] / pBase[ line ];
+			__m512 zmmScale = _mm512_set1_ps( scale );
+
+			factor[ y ] -= scale * factor[ line ];
+
+			size_t x = line;
+			for( ; x + 16 <= width; x += 16 )
+			{
+				_mm512_storeu_ps( pLine + x, _mm512_fnmadd_ps( zmmScale, _mm512_loadu_ps( pBase + x ),
+                                                               _mm512_loadu_ps( pLine + x ) ) );
+			}
+			for( ; x < width; ++x )
+			{
+				pLine[ x ] -= scale * pBase[ x ];
+			}
+		}
+	}
+}
+#elif defined( __AVX2__ )
+void intrinsicsTransform( t_dataType* matrix, t_dataType* factor, size_t width, size_t stride )
+{
+	for( size_t line = 0; line < width - 1; ++line )
+	{
+        const float* pBase = matrix + line * stride;
+
+		for( size_t y = line + 1; y < width; ++y )
+		{
+            float* pLine = matrix + y * stride;
+			float scale = pLine[ line ] / pBase[ line ];
+			__m256 ymmScale = _mm256_set1_ps( scale );
+
+			factor[ y ] -= scale * factor[ line ];
+
+			size_t x = line;
+			for( ; x + 8 <= width; x += 8 )
+			{
+				_mm256_storeu_ps( pLine + x, _mm256_fnmadd_ps( ymmScale, _mm256_loadu_ps( pBase + x ),
+                                                               _mm256_loadu_ps( pLine + x ) ) );
+			}
+			for( ; x < width; ++x )
+			{
+				pLine[ x ] -= scale * pBase[ x ];
+			}
+		}
+	}
+}
+#else
+void intrinsicsTransform( t_dataType* matrix, t_dataType* factor, size_t width, size_t stride )
+{
+	for( size_t line = 0; line < width - 1; ++line )
+	{
+        const float* pBase = matrix + line * stride;
+
+		for( size_t y = line + 1; y < width; ++y )
+		{
+            float* pLine = matrix + y * stride;
+			float scale = pLine[ line ] / pBase[ line ];
+			__m128 xmmScale = _mm_set1_ps( scale );
+
+			factor[ y ] -= scale * factor[ line ];
+
+			size_t x = line;
+			for( ; x + 4 <= width; x += 4 )
+			{
+				_mm_storeu_ps( pLine + x, _mm_sub_ps( _mm_loadu_ps( pLine + x ),
+                                                      _mm_mul_ps( xmmScale, _mm_loadu_ps( pBase + x ) ) ) );
+			}
+			for( ; x < width; ++x )
+			{
+				pLine[ x ] -= scale * pBase[ x ];
+			}
+		}
+	}
+}
+#endif
+} // namespace DISPATCH_ISA
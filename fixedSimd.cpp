@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#include <array>
+#include <utility>
+
+#include <boost/simd/pack.hpp>
+#include <boost/simd/function/fma.hpp>
+#include <boost/simd/function/aligned_load.hpp>
+#include <boost/simd/function/aligned_store.hpp>
+
+#include "boostSimd.h"
+
+namespace bs = boost::simd;
+
+namespace
+{
+template< typename T >
+using t_fixedKernel = void (*)( T* matrix, T* factor );
+
+// Every bound and the stride are constants, so the pack loops unroll completely
+// and there is no tail. Works in place: the rows are N apart, a whole number of
+// packs, and t_vector buffers are pack aligned.
+template< typename T, size_t N >
+void fixedSimdKernel( T* matrix, T* factor )
+{
+	using t_pack = bs::pack<T>;
+
+    for( size_t line = 0; line < N - 1; ++line )
+    {
+        const size_t normLine = line & ~(t_pack::static_size - 1);
+        const T* pBase = matrix + getIndex( 0, line, N );
+        for( size_t y = line + 1; y < N; ++y )
+        {
+            T* pLine = matrix + getIndex( 0, y, N );
+            T scale = pLine[ line ] / pBase[ line ];
+            factor[ y ] = bs::fma( -scale, factor[ line ], factor[ y ] );
+
+            t_pack packScale( -scale );
+            for( size_t x = normLine; x < N; x += t_pack::static_size )
+            {
+                bs::aligned_store( bs::fma( packScale, bs::aligned_load<t_pack>( pBase + x ), bs::aligned_load<t_pack>( pLine + x ) ), pLine + x );
+            }
+        }
+    }
+}
+
+// Sizes that are not a whole number of packs on this target get no kernel
+template< typename T, size_t N >
+t_fixedKernel<T> getFixedKernel( std::true_type ) { return( &fixedSimdKernel<T, N> ); }
+
+template< typename T, size_t N >
+t_fixedKernel<T> getFixedKernel( std::false_type ) { return( nullptr ); }
+
+template< typename T, size_t N >
+std::pair<size_t, t_fixedKernel<T>> getFixedEntry()
+{
+    using t_fits = std::integral_constant<bool, N % bs::pack<T>::static_size == 0>;
+    return( std::make_pair( N, getFixedKernel<T, N>( t_fits() ) ) );
+}
+
+template< typename T >
+t_fixedKernel<T> findFixedKernel( size_t width )
+{
+    static const std::array<std::pair<size_t, t_fixedKernel<T>>, 5> table = { {
+        getFixedEntry<T, 8>(),
+        getFixedEntry<T, 16>(),
+        getFixedEntry<T, 32>(),
+        getFixedEntry<T, 64>(),
+        getFixedEntry<T, 128>() } };
+
+    for( const auto& entry : table )
+    {
+        if( entry.first == width )
+            return( entry.second );
+    }
+    return( nullptr );
+}
+} // namespace
+
+template< typename T >
+bool hasFixedSimdKernel( size_t width )
+{
+    return( findFixedKernel<T>( width ) != nullptr );
+}
+
+template< typename T >
+void fixedSimdTransform( t_vector<T>& matrix, t_vector<T>& factor )
+{
+    size_t width = factor.size();
+    t_fixedKernel<T> kernel = findFixedKernel<T>( width );
+    if( !kernel || matrix.size() != width * width )
+    {
+        simdTransform( matrix, factor );
+        return;
+    }
+    kernel( matrix.data(), factor.data() );
+}
+
+#define INSTANTIATE_FIXED_TRANSFORMS( T ) \
+template bool hasFixedSimdKernel<T>( size_t width ); \
+template void fixedSimdTransform( t_vector<T>& matrix, t_vector<T>& factor );
+
+INSTANTIATE_FIXED_TRANSFORMS( float )
+INSTANTIATE_FIXED_TRANSFORMS( double )
@@ -0,0 +1,421 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+#include <boost/simd/pack.hpp>
+#include <boost/simd/function/fma.hpp>
+#include <boost/simd/function/aligned_load.hpp>
+#include <boost/simd/function/aligned_store.hpp>
+
+#include "halfSimd.h"
+
+namespace bs = boost::simd;
+
+namespace
+{
+uint32_t getBits( float value )
+{
+    uint32_t bits;
+    std::memcpy( &bits, &value, sizeof( bits ) );
+    return( bits );
+}
+
+float getFloat( uint32_t bits )
+{
+    float value;
+    std::memcpy( &value, &bits, sizeof( value ) );
+    return( value );
+}
+
+// Drops the low shift bits of value, rounding to nearest even
+uint32_t roundShift( uint32_t value, unsigned shift )
+{
+    uint32_t result = value >> shift;
+    uint32_t remainder = value & ((1u << shift) - 1);
+    uint32_t half = 1u << (shift - 1);
+    if( remainder > half || (remainder == half && (result & 1)) )
+        ++result;
+    return( result );
+}
+} // namespace
+
+const char* Fp16Storage::getConversion()
+{
+#ifdef __F16C__
+    return( "F16C" );
+#else
+    return( "scalar" );
+#endif
+}
+
+float Fp16Storage::toFloat( uint16_t value )
+{
+    uint32_t sign = static_cast<uint32_t>( value & 0x8000 ) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+    if( exponent == 0 )
+    {
+        float subnormal = std::ldexp( static_cast<float>( mantissa ), -24 );
+        return( sign ? -subnormal : subnormal );
+    }
+    if( exponent == 0x1f )
+        return( getFloat( sign | 0x7f800000 | (mantissa << 13) ) );
+    return( getFloat( sign | ((exponent + 112) << 23) | (mantissa << 13) ) );
+}
+
+uint16_t Fp16Storage::fromFloat( float value )
+{
+    uint32_t bits = getBits( value );
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int exponent = static_cast<int>( (bits >> 23) & 0xff ) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+    if( ((bits >> 23) & 0xff) == 0xff )
+        return( static_cast<uint16_t>( sign | 0x7c00 | (mantissa ? 0x200 : 0) ) );
+    if( exponent >= 0x1f )
+        return( static_cast<uint16_t>( sign | 0x7c00 ) );
+    if( exponent <= 0 )
+    {
+        // Subnormal half, anything below half the smallest one rounds to zero
+        if( exponent < -10 )
+            return( static_cast<uint16_t>( sign ) );
+        return( static_cast<uint16_t>( sign | roundShift( mantissa | 0x800000, static_cast<unsigned>( 14 - exponent ) ) ) );
+    }
+    // A carry out of the mantissa moves to the next exponent, up to infinity
+    return( static_cast<uint16_t>( sign | roundShift( (static_cast<uint32_t>( exponent ) << 23) | mantissa, 13 ) ) );
+}
+
+const char* Bf16Storage::getConversion()
+{
+#if defined( __AVX512BF16__ ) && defined( __AVX512VL__ )
+    return( "AVX-512 BF16" );
+#elif defined( __AVX2__ )
+    return( "AVX2" );
+#elif defined( __SSE4_1__ )
+    return( "SSE 4.1" );
+#else
+    return( "scalar" );
+#endif
+}
+
+float Bf16Storage::toFloat( uint16_t value )
+{
+    return( getFloat( static_cast<uint32_t>( value ) << 16 ) );
+}
+
+uint16_t Bf16Storage::fromFloat( float value )
+{
+    uint32_t bits = getBits( value );
+    if( (bits & 0x7fffffff) > 0x7f800000 )
+        return( static_cast<uint16_t>( (bits >> 16) | 0x40 ) );
+    return( static_cast<uint16_t>( (bits + 0x7fff + ((bits >> 16) & 1)) >> 16 ) );
+}
+
+namespace
+{
+// Eight and four value conversions where the build has the instructions, false
+// leaves the values to the scalar loop. Small enough to inline into the kernels.
+inline bool widen8( Fp16Storage, const uint16_t* source, float* target )
+{
+#ifdef __F16C__
+    __m128i half = _mm_loadu_si128( reinterpret_cast<const __m128i*>( source ) );
+    _mm256_storeu_ps( target, _mm256_cvtph_ps( half ) );
+    return( true );
+#else
+    return( false );
+#endif // __F16C__
+}
+
+inline bool widen4( Fp16Storage, const uint16_t* source, float* target )
+{
+#ifdef __F16C__
+    __m128i half = _mm_loadl_epi64( reinterpret_cast<const __m128i*>( source ) );
+    _mm_storeu_ps( target, _mm_cvtph_ps( half ) );
+    return( true );
+#else
+    return( false );
+#endif // __F16C__
+}
+
+inline bool narrow8( Fp16Storage, const float* source, uint16_t* target )
+{
+#ifdef __F16C__
+    __m128i half = _mm256_cvtps_ph( _mm256_loadu_ps( source ), _MM_FROUND_TO_NEAREST_INT );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( target ), half );
+    return( true );
+#else
+    return( false );
+#endif // __F16C__
+}
+
+inline bool narrow4( Fp16Storage, const float* source, uint16_t* target )
+{
+#ifdef __F16C__
+    __m128i half = _mm_cvtps_ph( _mm_loadu_ps( source ), _MM_FROUND_TO_NEAREST_INT );
+    _mm_storel_epi64( reinterpret_cast<__m128i*>( target ), half );
+    return( true );
+#else
+    return( false );
+#endif // __F16C__
+}
+
+inline bool widen8( Bf16Storage, const uint16_t* source, float* target )
+{
+#ifdef __AVX2__
+    __m128i half = _mm_loadu_si128( reinterpret_cast<const __m128i*>( source ) );
+    __m256i bits = _mm256_slli_epi32( _mm256_cvtepu16_epi32( half ), 16 );
+    _mm256_storeu_ps( target, _mm256_castsi256_ps( bits ) );
+    return( true );
+#else
+    return( false );
+#endif // __AVX2__
+}
+
+inline bool widen4( Bf16Storage, const uint16_t* source, float* target )
+{
+#ifdef __SSE4_1__
+    __m128i half = _mm_loadl_epi64( reinterpret_cast<const __m128i*>( source ) );
+    __m128i bits = _mm_slli_epi32( _mm_cvtepu16_epi32( half ), 16 );
+    _mm_storeu_ps( target, _mm_castsi128_ps( bits ) );
+    return( true );
+#else
+    return( false );
+#endif // __SSE4_1__
+}
+
+// Round to nearest even on the integer bits: add 0x7fff plus the lowest kept bit.
+// NaN lanes take the truncated bits with the quiet bit set instead, as fromFloat.
+inline bool narrow8( Bf16Storage, const float* source, uint16_t* target )
+{
+#if defined( __AVX512BF16__ ) && defined( __AVX512VL__ )
+    __m128bh half = _mm256_cvtneps_pbh( _mm256_loadu_ps( source ) );
+    std::memcpy( target, &half, sizeof( half ) );
+    return( true );
+#elif defined( __AVX2__ )
+    __m256i bits = _mm256_castps_si256( _mm256_loadu_ps( source ) );
+    __m256i nan = _mm256_cmpgt_epi32( _mm256_and_si256( bits, _mm256_set1_epi32( 0x7fffffff ) ), _mm256_set1_epi32( 0x7f800000 ) );
+    __m256i quiet = _mm256_or_si256( _mm256_srli_epi32( bits, 16 ), _mm256_set1_epi32( 0x40 ) );
+    __m256i even = _mm256_and_si256( _mm256_srli_epi32( bits, 16 ), _mm256_set1_epi32( 1 ) );
+    bits = _mm256_srli_epi32( _mm256_add_epi32( bits, _mm256_add_epi32( _mm256_set1_epi32( 0x7fff ), even ) ), 16 );
+    bits = _mm256_blendv_epi8( bits, quiet, nan );
+    __m128i half = _mm_packus_epi32( _mm256_castsi256_si128( bits ), _mm256_extracti128_si256( bits, 1 ) );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( target ), half );
+    return( true );
+#else
+    return( false );
+#endif
+}
+
+inline bool narrow4( Bf16Storage, const float* source, uint16_t* target )
+{
+#ifdef __SSE4_1__
+    __m128i bits = _mm_castps_si128( _mm_loadu_ps( source ) );
+    __m128i nan = _mm_cmpgt_epi32( _mm_and_si128( bits, _mm_set1_epi32( 0x7fffffff ) ), _mm_set1_epi32( 0x7f800000 ) );
+    __m128i quiet = _mm_or_si128( _mm_srli_epi32( bits, 16 ), _mm_set1_epi32( 0x40 ) );
+    __m128i even = _mm_and_si128( _mm_srli_epi32( bits, 16 ), _mm_set1_epi32( 1 ) );
+    bits = _mm_srli_epi32( _mm_add_epi32( bits, _mm_add_epi32( _mm_set1_epi32( 0x7fff ), even ) ), 16 );
+    bits = _mm_blendv_epi8( bits, quiet, nan );
+    _mm_storel_epi64( reinterpret_cast<__m128i*>( target ), _mm_packus_epi32( bits, bits ) );
+    return( true );
+#else
+    return( false );
+#endif // __SSE4_1__
+}
+
+template< typename Storage >
+inline void widenValues( const uint16_t* source, float* target, size_t count )
+{
+    size_t x = 0;
+    while( x + 8 <= count && widen8( Storage(), source + x, target + x ) )
+        x += 8;
+    while( x + 4 <= count && widen4( Storage(), source + x, target + x ) )
+        x += 4;
+    for( ; x < count; ++x )
+    {
+        target[ x ] = Storage::toFloat( source[ x ] );
+    }
+}
+
+template< typename Storage >
+inline void narrowValues( const float* source, uint16_t* target, size_t count )
+{
+    size_t x = 0;
+    while( x + 8 <= count && narrow8( Storage(), source + x, target + x ) )
+        x += 8;
+    while( x + 4 <= count && narrow4( Storage(), source + x, target + x ) )
+        x += 4;
+    for( ; x < count; ++x )
+    {
+        target[ x ] = Storage::fromFloat( source[ x ] );
+    }
+}
+} // namespace
+
+void Fp16Storage::widen( const uint16_t* source, float* target, size_t count )
+{
+    widenValues<Fp16Storage>( source, target, count );
+}
+
+void Fp16Storage::narrow( const float* source, uint16_t* target, size_t count )
+{
+    narrowValues<Fp16Storage>( source, target, count );
+}
+
+void Bf16Storage::widen( const uint16_t* source, float* target, size_t count )
+{
+    widenValues<Bf16Storage>( source, target, count );
+}
+
+void Bf16Storage::narrow( const float* source, uint16_t* target, size_t count )
+{
+    narrowValues<Bf16Storage>( source, target, count );
+}
+
+template< typename Storage >
+void toStorage( const t_vector<float>& matrix, t_halfVector& half )
+{
+    half.resize( matrix.size() );
+    Storage::narrow( matrix.data(), half.data(), matrix.size() );
+}
+
+template< typename Storage >
+void fromStorage( const t_halfVector& half, t_vector<float>& matrix )
+{
+    matrix.resize( half.size() );
+    Storage::widen( half.data(), matrix.data(), half.size() );
+}
+
+namespace
+{
+using t_pack = bs::pack<float>;
+
+// Pivot row from normLine to the end of the stride, widened once per pivot
+// line. Sized to whole packs so the last chunk loads in full.
+template< typename Storage >
+void widenPivot( const t_halfVector& matrix, t_vector<float>& pivot, size_t line, size_t normLine, size_t stride )
+{
+    pivot.resize( getStride<float>( stride ) );
+    widenValues<Storage>( &matrix[ getIndex( normLine, line, stride ) ], &pivot[ normLine ], stride - normLine );
+}
+
+// row -= scale * pivot from normLine on, one pack at a time through an aligned
+// float buffer that stays in registers or L1
+template< typename Storage >
+void eliminateRow( uint16_t* row, const float* pivot, float scale, size_t normLine, size_t stride )
+{
+    alignas( sizeof( t_pack ) ) float buffer[ t_pack::static_size ] = {};
+    t_pack packScale( -scale );
+    size_t x = normLine;
+    for( ; x + t_pack::static_size <= stride; x += t_pack::static_size )
+    {
+        widenValues<Storage>( row + x, buffer, t_pack::static_size );
+        t_pack packLine = bs::fma( packScale, bs::aligned_load<t_pack>( pivot + x ), bs::aligned_load<t_pack>( buffer ) );
+        bs::aligned_store( packLine, buffer );
+        narrowValues<Storage>( buffer, row + x, t_pack::static_size );
+    }
+    if( x < stride )
+    {
+        widenValues<Storage>( row + x, buffer, stride - x );
+        t_pack packLine = bs::fma( packScale, bs::aligned_load<t_pack>( pivot + x ), bs::aligned_load<t_pack>( buffer ) );
+        bs::aligned_store( packLine, buffer );
+        narrowValues<Storage>( buffer, row + x, stride - x );
+    }
+}
+} // namespace
+
+template< typename Storage >
+void halfSimdTransform( t_halfVector& matrix, t_vector<float>& factor )
+{
+    size_t width = factor.size();
+    size_t stride = matrix.size() / width;
+    t_vector<float> pivot;
+    for( size_t line = 0; line < width - 1; ++line )
+    {
+        size_t normLine = line & ~(static_cast<size_t>(t_pack::static_size - 1));
+        widenPivot<Storage>( matrix, pivot, line, normLine, stride );
+        for( size_t y = line + 1; y < width; ++y )
+        {
+            uint16_t* row = &matrix[ getIndex( 0, y, stride ) ];
+            float scale = Storage::toFloat( row[ line ] ) / pivot[ line ];
+            factor[ y ] = bs::fma( -scale, factor[ line ], factor[ y ] );
+            eliminateRow<Storage>( row, pivot.data(), scale, normLine, stride );
+        }
+    }
+}
+
+#ifdef _OPENMP
+template< typename Storage >
+void halfSimdOpenMPTransform( t_halfVector& matrix, t_vector<float>& factor )
+{
+    int width = static_cast<int>( factor.size() );
+    size_t stride = matrix.size() / width;
+    t_vector<float> pivot;
+    for( int line = 0; line < width - 1; ++line )
+    {
+        size_t normLine = line & ~(static_cast<int>(t_pack::static_size - 1));
+        widenPivot<Storage>( matrix, pivot, line, normLine, stride );
+        #pragma omp parallel for
+        for( int y = line + 1; y < width; ++y )
+        {
+            uint16_t* row = &matrix[ getIndex( 0, y, stride ) ];
+            float scale = Storage::toFloat( row[ line ] ) / pivot[ line ];
+            factor[ y ] = bs::fma( -scale, factor[ line ], factor[ y ] );
+            eliminateRow<Storage>( row, pivot.data(), scale, normLine, stride );
+        }
+    }
+}
+#define INSTANTIATE_HALF_OPENMP_TRANSFORM( Storage ) \
+template void halfSimdOpenMPTransform<Storage>( t_halfVector& matrix, t_vector<float>& factor );
+#else
+#define INSTANTIATE_HALF_OPENMP_TRANSFORM( Storage )
+#endif // _OPENMP
+
+template< typename Storage >
+void halfBackSubstitution( const t_halfVector& matrix, t_vector<float>& factor )
+{
+    size_t width = factor.size();
+    size_t stride = matrix.size() / width;
+    t_vector<float> row( width );
+    for( size_t y = width; y-- > 0; )
+    {
+        widenValues<Storage>( &matrix[ getIndex( y, y, stride ) ], row.data(), width - y );
+        float sum = factor[ y ];
+        for( size_t x = 1; x < width - y; ++x )
+        {
+            sum -= row[ x ] * factor[ y + x ];
+        }
+        factor[ y ] = sum / row[ 0 ];
+    }
+}
+
+#define INSTANTIATE_HALF( Storage ) \
+template void toStorage<Storage>( const t_vector<float>& matrix, t_halfVector& half ); \
+template void fromStorage<Storage>( const t_halfVector& half, t_vector<float>& matrix ); \
+template void halfSimdTransform<Storage>( t_halfVector& matrix, t_vector<float>& factor ); \
+template void halfBackSubstitution<Storage>( const t_halfVector& matrix, t_vector<float>& factor ); \
+INSTANTIATE_HALF_OPENMP_TRANSFORM( Storage )
+
+INSTANTIATE_HALF( Fp16Storage )
+INSTANTIATE_HALF( Bf16Storage )
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#ifndef __HALF_SIMD__
+#define __HALF_SIMD__
+
+#include <cstdint>
+#include "boostSimd.h"
+
+// 16 bit storage for float matrices. The kernels widen each chunk of a row to a
+// float pack on load, compute in float and round back to nearest even on store,
+// so the matrix takes half the memory and traffic of a t_dataVector.
+using t_halfVector = t_vector<uint16_t>;
+
+// IEEE half precision: 10 bit mantissa, largest finite value 65504. widen and
+// narrow convert count values, with F16C when the build targets it.
+struct Fp16Storage
+{
+    static const char* getName() { return( "fp16" ); }
+    static const char* getConversion();
+    static float toFloat( uint16_t value );
+    static uint16_t fromFloat( float value );
+    static void widen( const uint16_t* source, float* target, size_t count );
+    static void narrow( const float* source, uint16_t* target, size_t count );
+};
+
+// bfloat16: the float exponent range with a 7 bit mantissa. Narrowing uses the
+// AVX-512 BF16 instructions when built for them, which flush float subnormals to
+// zero, integer rounding on AVX2 and SSE 4.1 otherwise. Every path narrows NaN
+// to a quiet NaN, the scalar and integer ones keeping the top of the payload.
+struct Bf16Storage
+{
+    static const char* getName() { return( "bf16" ); }
+    static const char* getConversion();
+    static float toFloat( uint16_t value );
+    static uint16_t fromFloat( float value );
+    static void widen( const uint16_t* source, float* target, size_t count );
+    static void narrow( const float* source, uint16_t* target, size_t count );
+};
+
+// Conversions from and to a float matrix of the same size, padding included
+template< typename Storage > void toStorage( const t_vector<float>& matrix, t_halfVector& half );
+template< typename Storage > void fromStorage( const t_halfVector& half, t_vector<float>& matrix );
+
+// simdTransform on a matrix held in Storage, factor stays float. Rows of
+// getStride<float>( width ) keep every chunk a whole pack, any other stride
+// converts a partial last chunk.
+template< typename Storage > void halfSimdTransform( t_halfVector& matrix, t_vector<float>& factor );
+#ifdef _OPENMP
+template< typename Storage > void halfSimdOpenMPTransform( t_halfVector& matrix, t_vector<float>& factor );
+#endif // _OPENMP
+template< typename Storage > void halfBackSubstitution( const t_halfVector& matrix, t_vector<float>& factor );
+
+#endif // __HALF_SIMD__
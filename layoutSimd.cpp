@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#include <algorithm>
+
+#include <boost/simd/pack.hpp>
+#include <boost/simd/function/fma.hpp>
+#include <boost/simd/function/load.hpp>
+#include <boost/simd/function/store.hpp>
+#include <boost/simd/function/aligned_load.hpp>
+#include <boost/simd/function/aligned_store.hpp>
+
+#include "layoutSimd.h"
+
+namespace bs = boost::simd;
+
+namespace
+{
+// column[ y ] -= scales[ y ] * value for the count elements from column
+template< typename T >
+void fmaColumn( T* column, const T* scales, T value, size_t count )
+{
+	using t_pack = bs::pack<T>;
+
+    t_pack packValue( -value );
+    size_t y = 0;
+    for( ; y + t_pack::static_size <= count; y += t_pack::static_size )
+    {
+        bs::store( bs::fma( bs::aligned_load<t_pack>( scales + y ), packValue, bs::load<t_pack>( column + y ) ), column + y );
+    }
+    for( ; y < count; ++y )
+    {
+        column[ y ] -= scales[ y ] * value;
+    }
+}
+
+// Contiguous pivot column: multipliers with one reciprocal and packed
+// multiplies, factor updated with them
+template< typename T >
+void columnMultipliers( const T* column, t_vector<T>& factor, size_t line, t_vector<T>& scales )
+{
+    size_t width = factor.size();
+    T reciprocal = 1 / column[ line ];
+    for( size_t y = line + 1; y < width; ++y )
+    {
+        scales[ y - line - 1 ] = column[ y ] * reciprocal;
+    }
+    fmaColumn( factor.data() + line + 1, scales.data(), factor[ line ], width - line - 1 );
+}
+
+// Row y of a tiled matrix from column line on, one aligned pack loop per tile
+template< typename T >
+void fmaTiledRow( T* matrix, size_t line, size_t y, size_t width, T scale )
+{
+	using t_pack = bs::pack<T>;
+
+    const size_t tileSize = TiledLayout::tileSize_;
+    size_t normLine = line & ~(static_cast<size_t>(t_pack::static_size - 1));
+    t_pack packScale( -scale );
+    for( size_t tileX = line / tileSize; tileX < TiledLayout::getTiles( width ); ++tileX )
+    {
+        size_t x = std::max( normLine, tileX * tileSize );
+        T* pLine = &( matrix[ TiledLayout::getIndex<T>( x, y, width ) ] );
+        const T* pBase = &( matrix[ TiledLayout::getIndex<T>( x, line, width ) ] );
+        for( size_t i = 0; i < (tileX + 1) * tileSize - x; i += t_pack::static_size )
+        {
+            bs::aligned_store( bs::fma( packScale, bs::aligned_load<t_pack>( pBase + i ), bs::aligned_load<t_pack>( pLine + i ) ), pLine + i );
+        }
+    }
+}
+
+template< typename T >
+void transform( RowMajorLayout, t_vector<T>& matrix, t_vector<T>& factor )
+{
+    simdTransform( matrix, factor );
+}
+
+template< typename T >
+void transform( ColumnMajorLayout, t_vector<T>& matrix, t_vector<T>& factor )
+{
+    size_t width = factor.size();
+    size_t stride = getStride<T>( width );
+    t_vector<T> scales( width );
+    for( size_t line = 0; line < width - 1; ++line )
+    {
+        columnMultipliers( &matrix[ getIndex( 0, line, stride ) ], factor, line, scales );
+        for( size_t x = line; x < width; ++x )
+        {
+            T* column = &( matrix[ getIndex( 0, x, stride ) ] );
+            fmaColumn( column + line + 1, scales.data(), column[ line ], width - line - 1 );
+        }
+    }
+}
+
+template< typename T >
+void transform( TiledLayout, t_vector<T>& matrix, t_vector<T>& factor )
+{
+    size_t width = factor.size();
+    for( size_t line = 0; line < width - 1; ++line )
+    {
+        T pivot = matrix[ TiledLayout::getIndex<T>( line, line, width ) ];
+        for( size_t y = line + 1; y < width; ++y )
+        {
+            T scale = matrix[ TiledLayout::getIndex<T>( line, y, width ) ] / pivot;
+            factor[ y ] = bs::fma( -scale, factor[ line ], factor[ y ] );
+            fmaTiledRow( matrix.data(), line, y, width, scale );
+        }
+    }
+}
+
+#ifdef _OPENMP
+template< typename T >
+void openMPTransform( RowMajorLayout, t_vector<T>& matrix, t_vector<T>& factor )
+{
+    simdOpenMPTransform( matrix, factor );
+}
+
+template< typename T >
+void openMPTransform( ColumnMajorLayout, t_vector<T>& matrix, t_vector<T>& factor )
+{
+    int width = static_cast<int>( factor.size() );
+    size_t stride = getStride<T>( width );
+    t_vector<T> scales( width );
+    for( int line = 0; line < width - 1; ++line )
+    {
+        columnMultipliers( &matrix[ getIndex( 0, line, stride ) ], factor, line, scales );
+
+        #pragma omp parallel for
+        for( int x = line; x < width; ++x )
+        {
+            T* column = &( matrix[ getIndex( 0, x, stride ) ] );
+            fmaColumn( column + line + 1, scales.data(), column[ line ], width - line - 1 );
+        }
+    }
+}
+
+template< typename T >
+void openMPTransform( TiledLayout, t_vector<T>& matrix, t_vector<T>& factor )
+{
+    int width = static_cast<int>( factor.size() );
+    for( int line = 0; line < width - 1; ++line )
+    {
+        T pivot = matrix[ TiledLayout::getIndex<T>( line, line, width ) ];
+
+        #pragma omp parallel for
+        for( int y = line + 1; y < width; ++y )
+        {
+            T scale = matrix[ TiledLayout::getIndex<T>( line, y, width ) ] / pivot;
+            factor[ y ] = bs::fma( -scale, factor[ line ], factor[ y ] );
+            fmaTiledRow( matrix.data(), line, y, width, scale );
+        }
+    }
+}
+#endif // _OPENMP
+} // namespace
+
+template< typename T, typename Layout >
+void toLayout( const t_vector<T>& rowMajor, t_vector<T>& matrix, size_t width )
+{
+    matrix.assign( Layout::template getSize<T>( width ), T( 0 ) );
+    for( size_t y = 0; y < width; ++y )
+    {
+        for( size_t x = 0; x < width; ++x )
+        {
+            matrix[ Layout::template getIndex<T>( x, y, width ) ] = rowMajor[ getIndex( x, y, width ) ];
+        }
+    }
+}
+
+template< typename T, typename Layout >
+void fromLayout( const t_vector<T>& matrix, t_vector<T>& rowMajor, size_t width )
+{
+    rowMajor.resize( width * width );
+    for( size_t y = 0; y < width; ++y )
+    {
+        for( size_t x = 0; x < width; ++x )
+        {
+            rowMajor[ getIndex( x, y, width ) ] = matrix[ Layout::template getIndex<T>( x, y, width ) ];
+        }
+    }
+}
+
+template< typename T, typename Layout >
+void layoutSimdTransform( t_vector<T>& matrix, t_vector<T>& factor )
+{
+    transform( Layout(), matrix, factor );
+}
+
+#ifdef _OPENMP
+template< typename T, typename Layout >
+void layoutSimdOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor )
+{
+    openMPTransform( Layout(), matrix, factor );
+}
+#define INSTANTIATE_LAYOUT_OPENMP_TRANSFORM( T, Layout ) \
+template void layoutSimdOpenMPTransform<T, Layout>( t_vector<T>& matrix, t_vector<T>& factor );
+#else
+#define INSTANTIATE_LAYOUT_OPENMP_TRANSFORM( T, Layout )
+#endif // _OPENMP
+
+#define INSTANTIATE_LAYOUT( T, Layout ) \
+template void toLayout<T, Layout>( const t_vector<T>& rowMajor, t_vector<T>& matrix, size_t width ); \
+template void fromLayout<T, Layout>( const t_vector<T>& matrix, t_vector<T>& rowMajor, size_t width ); \
+template void layoutSimdTransform<T, Layout>( t_vector<T>& matrix, t_vector<T>& factor ); \
+INSTANTIATE_LAYOUT_OPENMP_TRANSFORM( T, Layout )
+
+INSTANTIATE_LAYOUT( float, RowMajorLayout )
+INSTANTIATE_LAYOUT( float, ColumnMajorLayout )
+INSTANTIATE_LAYOUT( float, TiledLayout )
+INSTANTIATE_LAYOUT( double, RowMajorLayout )
+INSTANTIATE_LAYOUT( double, ColumnMajorLayout )
+INSTANTIATE_LAYOUT( double, TiledLayout )
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#ifndef __LAYOUT_SIMD__
+#define __LAYOUT_SIMD__
+
+#include "boostSimd.h"
+
+// Storage layouts of a width x width matrix. getSize is the element count to
+// allocate, getIndex the position of column x, row y. Every layout pads to
+// whole packs so the kernels stay aligned; padding holds zeros after toLayout.
+struct RowMajorLayout
+{
+    static const char* getName() { return( "row major" ); }
+    template< typename T > static size_t getSize( size_t width ) { return( width * getStride<T>( width ) ); }
+    template< typename T > static size_t getIndex( size_t x, size_t y, size_t width ) { return( ::getIndex( x, y, getStride<T>( width ) ) ); }
+};
+
+// Pivot columns are contiguous, elimination runs as column updates
+struct ColumnMajorLayout
+{
+    static const char* getName() { return( "column major" ); }
+    template< typename T > static size_t getSize( size_t width ) { return( width * getStride<T>( width ) ); }
+    template< typename T > static size_t getIndex( size_t x, size_t y, size_t width ) { return( ::getIndex( y, x, getStride<T>( width ) ) ); }
+};
+
+// Square tiles of tileSize_ x tileSize_ elements, row major inside a tile and
+// from tile to tile. A pivot column is tileSize_ elements apart instead of a
+// whole row.
+struct TiledLayout
+{
+    static const size_t tileSize_ = 32;
+
+    static const char* getName() { return( "tiled" ); }
+    static size_t getTiles( size_t width ) { return( (width + tileSize_ - 1) / tileSize_ ); }
+    template< typename T > static size_t getSize( size_t width ) { return( getTiles( width ) * getTiles( width ) * tileSize_ * tileSize_ ); }
+    template< typename T > static size_t getIndex( size_t x, size_t y, size_t width )
+    {
+        return( ((y / tileSize_) * getTiles( width ) + x / tileSize_) * tileSize_ * tileSize_ + (y % tileSize_) * tileSize_ + x % tileSize_ );
+    }
+};
+
+// Conversions from and to the plain row major matrix (stride = width) the
+// other transforms use
+template< typename T, typename Layout > void toLayout( const t_vector<T>& rowMajor, t_vector<T>& matrix, size_t width );
+template< typename T, typename Layout > void fromLayout( const t_vector<T>& matrix, t_vector<T>& rowMajor, size_t width );
+
+// matrix in Layout, width = factor.size(), same result as simdTransform
+template< typename T, typename Layout > void layoutSimdTransform( t_vector<T>& matrix, t_vector<T>& factor );
+#ifdef _OPENMP
+template< typename T, typename Layout > void layoutSimdOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor );
+#endif // _OPENMP
+
+#endif // __LAYOUT_SIMD__
@@ -0,0 +1,535 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <stdexcept>
+
+#include <boost/simd/pack.hpp>
+#include <boost/simd/function/abs.hpp>
+#include <boost/simd/function/max.hpp>
+#include <boost/simd/function/maximum.hpp>
+#include <boost/simd/function/sum.hpp>
+#include <boost/simd/function/fma.hpp>
+#include <boost/simd/function/load.hpp>
+#include <boost/simd/function/aligned_load.hpp>
+#include <boost/simd/function/store.hpp>
+
+#include "boostSimd.h"
+
+namespace bs = boost::simd;
+
+namespace
+{
+// Gathers the pivot column of the rows still to be eliminated into a contiguous
+// buffer and returns the row holding its largest absolute value.
+template< typename T >
+size_t findPivot( const t_vector<T>& matrix, const t_indexVector& rows, size_t line, t_vector<T>& column )
+{
+	using t_pack = bs::pack<T>;
+
+    size_t width = rows.size();
+    size_t stride = matrix.size() / width;
+    size_t count = width - line;
+    for( size_t y = line; y < width; ++y )
+    {
+        column[ y - line ] = matrix[ getIndex( line, rows[ y ], stride ) ];
+    }
+
+    size_t y = 0;
+    t_pack packMax( T( 0 ) );
+    for( ; y + t_pack::static_size <= count; y += t_pack::static_size )
+    {
+        packMax = bs::max( packMax, bs::abs( bs::aligned_load<t_pack>( column.data() + y ) ) );
+    }
+
+    T maxValue = bs::maximum( packMax );
+    for( ; y < count; ++y )
+    {
+        maxValue = std::max( maxValue, std::abs( column[ y ] ) );
+    }
+
+    for( y = 0; y < count - 1; ++y )
+    {
+        if( std::abs( column[ y ] ) == maxValue )
+            break;
+    }
+    return( line + y );
+}
+
+// Elimination with partial pivoting over a row permutation, no row is moved.
+// Column line of each eliminated row receives its multiplier (LU form) or zero.
+template< typename T >
+void pivotEliminate( t_vector<T>& matrix, t_vector<T>* factor, t_indexVector& rows, bool keepMultipliers )
+{
+	using t_pack = bs::pack<T>;
+
+    size_t width = rows.size();
+    size_t stride = matrix.size() / width;
+    t_vector<T> column( width );
+
+    std::iota( rows.begin(), rows.end(), 0 );
+    for( size_t line = 0; line < width - 1; ++line )
+    {
+        size_t pivotRow = findPivot( matrix, rows, line, column );
+        if( pivotRow != line )
+        {
+            std::swap( rows[ line ], rows[ pivotRow ] );
+            std::swap( column[ 0 ], column[ pivotRow - line ] );
+        }
+
+        const T* pBase = &( matrix[ getIndex( 0, rows[ line ], stride ) ] );
+        size_t baseRow = rows[ line ];
+        T pivot = column[ 0 ];
+
+        for( size_t y = line + 1; y < width; ++y )
+        {
+            size_t row = rows[ y ];
+            T scale = column[ y - line ] / pivot;
+            if( factor )
+            {
+                (*factor)[ row ] = bs::fma( -scale, (*factor)[ baseRow ], (*factor)[ row ] );
+            }
+            T* pLine = &( matrix[ getIndex( 0, row, stride ) ] );
+            pLine[ line ] = keepMultipliers ? scale : 0;
+
+            // Columns left of line + 1 hold multipliers, so the update starts unaligned
+            size_t x = line + 1;
+            t_pack packScale( -scale );
+            for( ; x + t_pack::static_size <= width; x += t_pack::static_size )
+            {
+                bs::store( bs::fma( packScale, bs::load<t_pack>( pBase + x ), bs::load<t_pack>( pLine + x ) ), pLine + x );
+            }
+            for( ; x < width; ++x )
+            {
+                pLine[ x ] -= scale * pBase[ x ];
+            }
+        }
+    }
+}
+
+template< typename T >
+void permuteRows( t_vector<T>& matrix, const t_indexVector& rows, size_t width )
+{
+    size_t stride = matrix.size() / width;
+    t_vector<T> permuted( matrix.size() );
+    for( size_t y = 0; y < rows.size(); ++y )
+    {
+        std::copy_n( matrix.begin() + getIndex( 0, rows[ y ], stride ), stride,
+                     permuted.begin() + getIndex( 0, y, stride ) );
+    }
+    matrix.swap( permuted );
+}
+
+template< typename T >
+T dotProduct( const T* lhs, const T* rhs, size_t count )
+{
+	using t_pack = bs::pack<T>;
+
+    size_t x = 0;
+    t_pack packSum( T( 0 ) );
+    for( ; x + t_pack::static_size <= count; x += t_pack::static_size )
+    {
+        packSum = bs::fma( bs::load<t_pack>( lhs + x ), bs::load<t_pack>( rhs + x ), packSum );
+    }
+
+    T sum = bs::sum( packSum );
+    for( ; x < count; ++x )
+    {
+        sum += lhs[ x ] * rhs[ x ];
+    }
+    return( sum );
+}
+
+// line -= scale * base over a whole right-hand side block row
+template< typename T >
+void fmaFactorRow( T* line, const T* base, T scale, size_t stride )
+{
+	using t_pack = bs::pack<T>;
+
+    t_pack* packLine = reinterpret_cast<t_pack*>( line );
+    const t_pack* packBase = reinterpret_cast<const t_pack*>( base );
+    t_pack packScale( -scale );
+    for( size_t x = 0; x < stride; x += t_pack::static_size )
+    {
+        *packLine = bs::fma( packScale, *packBase++, *packLine );
+        packLine++;
+    }
+}
+
+// line[ 0, count ) -= scale * column[ 0, count ), packs up to the last whole one
+// and scalars after it, so nothing past count is touched
+template< typename T >
+void fmaLowerRow( T* line, const T* column, T scale, size_t count )
+{
+	using t_pack = bs::pack<T>;
+
+    t_pack packScale( -scale );
+    size_t x = 0;
+    for( ; x + t_pack::static_size <= count; x += t_pack::static_size )
+    {
+        bs::store( bs::fma( packScale, bs::load<t_pack>( column + x ), bs::load<t_pack>( line + x ) ), line + x );
+    }
+    for( ; x < count; ++x )
+    {
+        line[ x ] -= scale * column[ x ];
+    }
+}
+
+// One Bennett step on the part right of and below pivot i, for one update:
+// row of U, column of L (gathered), x and y, all from index i + 1 on
+template< typename T >
+void bennettStep( T* row, T* column, T* x, T* y, T xi, T yi, size_t count )
+{
+	using t_pack = bs::pack<T>;
+
+    t_pack packX( xi );
+    t_pack packY( yi );
+    size_t j = 0;
+    for( ; j + t_pack::static_size <= count; j += t_pack::static_size )
+    {
+        t_pack packRow = bs::fma( packX, bs::load<t_pack>( y + j ), bs::load<t_pack>( row + j ) );
+        t_pack packXj = bs::fma( -packX, bs::load<t_pack>( column + j ), bs::load<t_pack>( x + j ) );
+        bs::store( packRow, row + j );
+        bs::store( packXj, x + j );
+        bs::store( bs::fma( packY, packXj, bs::load<t_pack>( column + j ) ), column + j );
+        bs::store( bs::fma( -packY, packRow, bs::load<t_pack>( y + j ) ), y + j );
+    }
+    for( ; j < count; ++j )
+    {
+        row[ j ] += xi * y[ j ];
+        x[ j ] -= xi * column[ j ];
+        column[ j ] += yi * x[ j ];
+        y[ j ] -= yi * row[ j ];
+    }
+}
+
+template< typename T >
+void scaleFactorRow( T* line, T scale, size_t stride )
+{
+	using t_pack = bs::pack<T>;
+
+    t_pack* packLine = reinterpret_cast<t_pack*>( line );
+    t_pack packScale( scale );
+    for( size_t x = 0; x < stride; x += t_pack::static_size )
+    {
+        *packLine = *packLine * packScale;
+        packLine++;
+    }
+}
+} // namespace
+
+template< typename T >
+void pivotSimdTransform( t_vector<T>& matrix, t_vector<T>& factor )
+{
+    size_t width = factor.size();
+    t_indexVector rows( width );
+    pivotEliminate( matrix, &factor, rows, false );
+
+    permuteRows( matrix, rows, width );
+    t_vector<T> permutedFactor( width );
+    for( size_t y = 0; y < width; ++y )
+    {
+        permutedFactor[ y ] = factor[ rows[ y ] ];
+    }
+    factor.swap( permutedFactor );
+}
+
+template< typename T >
+void luFactor( t_vector<T>& matrix, t_indexVector& permutation )
+{
+    pivotEliminate<T>( matrix, nullptr, permutation, true );
+    permuteRows( matrix, permutation, permutation.size() );
+}
+
+template< typename T >
+void luSolve( const t_vector<T>& lu, const t_indexVector& permutation, t_vector<T>& factor )
+{
+    size_t width = permutation.size();
+    size_t stride = lu.size() / width;
+    t_vector<T> solution( width );
+
+    // Forward substitution, L has an implicit unit diagonal
+    for( size_t y = 0; y < width; ++y )
+    {
+        solution[ y ] = factor[ permutation[ y ] ]
+                      - dotProduct( &lu[ getIndex( 0, y, stride ) ], solution.data(), y );
+    }
+
+    backSubstitution( lu, solution );
+    factor.swap( solution );
+}
+
+template< typename T >
+void luSolveBlock( const t_vector<T>& lu, const t_indexVector& permutation, t_vector<T>& factors, size_t rhsCount )
+{
+    size_t width = permutation.size();
+    size_t luStride = lu.size() / width;
+    size_t stride = getFactorStride<T>( rhsCount );
+    t_vector<T> solutions( factors.size() );
+
+    for( size_t y = 0; y < width; ++y )
+    {
+        T* pLine = &( solutions[ getIndex( 0, y, stride ) ] );
+        std::copy_n( &factors[ getIndex( 0, permutation[ y ], stride ) ], stride, pLine );
+        for( size_t x = 0; x < y; ++x )
+        {
+            fmaFactorRow( pLine, &solutions[ getIndex( 0, x, stride ) ], lu[ getIndex( x, y, luStride ) ], stride );
+        }
+    }
+
+    backSubstitutionBlock( lu, solutions, rhsCount );
+    factors.swap( solutions );
+}
+
+template< typename T >
+void backSubstitution( const t_vector<T>& matrix, t_vector<T>& factor )
+{
+    size_t width = factor.size();
+    size_t stride = matrix.size() / width;
+    for( size_t y = width; y-- > 0; )
+    {
+        factor[ y ] = ( factor[ y ] - dotProduct( &matrix[ getIndex( y + 1, y, stride ) ],
+                                                  factor.data() + y + 1, width - y - 1 ) )
+                    / matrix[ getIndex( y, y, stride ) ];
+    }
+}
+
+template< typename T >
+void backSubstitutionBlock( const t_vector<T>& matrix, t_vector<T>& factors, size_t rhsCount )
+{
+    size_t stride = getFactorStride<T>( rhsCount );
+    size_t width = factors.size() / stride;
+    size_t matrixStride = matrix.size() / width;
+    for( size_t y = width; y-- > 0; )
+    {
+        T* pLine = &( factors[ getIndex( 0, y, stride ) ] );
+        for( size_t x = y + 1; x < width; ++x )
+        {
+            fmaFactorRow( pLine, &factors[ getIndex( 0, x, stride ) ], matrix[ getIndex( x, y, matrixStride ) ], stride );
+        }
+        scaleFactorRow( pLine, 1 / matrix[ getIndex( y, y, matrixStride ) ], stride );
+    }
+}
+
+// Bennett's algorithm with the pivot loop outside the updates: step i of every
+// update only touches row i of U and column i of L, so the k updates share one
+// pass over the factorization, the column gathered once for all of them
+template< typename T >
+void luUpdate( t_vector<T>& lu, const t_indexVector& permutation, const t_vector<T>& x, const t_vector<T>& y, size_t rank )
+{
+    size_t width = permutation.size();
+    size_t stride = lu.size() / width;
+    t_vector<T> xs( rank * width );
+    t_vector<T> ys( y.begin(), y.begin() + rank * width );
+    for( size_t r = 0; r < rank; ++r )
+    {
+        for( size_t i = 0; i < width; ++i )
+        {
+            xs[ r * width + i ] = x[ r * width + permutation[ i ] ];
+        }
+    }
+
+    t_vector<T> column( width );
+    for( size_t i = 0; i < width; ++i )
+    {
+        T* pRow = &( lu[ getIndex( 0, i, stride ) ] );
+        for( size_t j = i + 1; j < width; ++j )
+        {
+            column[ j ] = lu[ getIndex( i, j, stride ) ];
+        }
+        for( size_t r = 0; r < rank; ++r )
+        {
+            T* pX = &( xs[ r * width ] );
+            T* pY = &( ys[ r * width ] );
+            pRow[ i ] += pX[ i ] * pY[ i ];
+            pY[ i ] /= pRow[ i ];
+            bennettStep( pRow + i + 1, &column[ i + 1 ], pX + i + 1, pY + i + 1, pX[ i ], pY[ i ], width - i - 1 );
+        }
+        for( size_t j = i + 1; j < width; ++j )
+        {
+            lu[ getIndex( i, j, stride ) ] = column[ j ];
+        }
+    }
+}
+
+// The old row comes back from the factors, row q of L times U, in O(n^2)
+template< typename T >
+void luReplaceRow( t_vector<T>& lu, const t_indexVector& permutation, size_t row, const t_vector<T>& values )
+{
+    size_t width = permutation.size();
+    size_t stride = lu.size() / width;
+    size_t q = std::find( permutation.begin(), permutation.end(), row ) - permutation.begin();
+
+    t_vector<T> y( values.begin(), values.begin() + width );
+    for( size_t m = 0; m <= q; ++m )
+    {
+        T l = m == q ? T( 1 ) : lu[ getIndex( m, q, stride ) ];
+        fmaLowerRow( y.data() + m, &lu[ getIndex( m, m, stride ) ], l, width - m );
+    }
+    t_vector<T> x( width, T( 0 ) );
+    x[ row ] = 1;
+    luUpdate( lu, permutation, x, y, 1 );
+}
+
+// Right looking on the lower triangle: column k of L is gathered into a
+// contiguous buffer once, then every row below takes it with packed fma over
+// its own part of the trailing lower triangle only. The buffer is zero up to
+// k, so the updates start on a pack boundary and leave finished L unchanged.
+template< typename T >
+bool choleskyFactor( t_vector<T>& matrix, size_t width )
+{
+	using t_pack = bs::pack<T>;
+
+    size_t stride = matrix.size() / width;
+    t_vector<T> column( width );
+    for( size_t k = 0; k < width; ++k )
+    {
+        size_t normK = (k + 1) & ~(static_cast<size_t>(t_pack::static_size - 1));
+        column[ k ] = 0;
+        T pivot = matrix[ getIndex( k, k, stride ) ];
+        if( !(pivot > 0) )
+            return( false );
+        T diagonal = std::sqrt( pivot );
+        T reciprocal = 1 / diagonal;
+        matrix[ getIndex( k, k, stride ) ] = diagonal;
+        for( size_t y = k + 1; y < width; ++y )
+        {
+            column[ y ] = matrix[ getIndex( k, y, stride ) ] *= reciprocal;
+        }
+        for( size_t y = k + 1; y < width; ++y )
+        {
+            fmaLowerRow( &matrix[ getIndex( normK, y, stride ) ], &column[ normK ], column[ y ], y + 1 - normK );
+        }
+    }
+    return( true );
+}
+
+// L z = b with row dot products, then L^T x = z as column updates, so both
+// passes read rows of L
+template< typename T >
+void choleskySolve( const t_vector<T>& l, t_vector<T>& factor )
+{
+    size_t width = factor.size();
+    size_t stride = l.size() / width;
+    for( size_t y = 0; y < width; ++y )
+    {
+        factor[ y ] = (factor[ y ] - dotProduct( &l[ getIndex( 0, y, stride ) ], factor.data(), y ))
+                    / l[ getIndex( y, y, stride ) ];
+    }
+    for( size_t y = width; y-- > 0; )
+    {
+        factor[ y ] /= l[ getIndex( y, y, stride ) ];
+        fmaLowerRow( factor.data(), &l[ getIndex( 0, y, stride ) ], factor[ y ], y );
+    }
+}
+
+template< typename T >
+void choleskySimdTransform( t_vector<T>& matrix, t_vector<T>& factor )
+{
+    size_t width = factor.size();
+    size_t stride = matrix.size() / width;
+    if( !choleskyFactor( matrix, width ) )
+        throw std::domain_error( "choleskySimdTransform: matrix is not positive definite" );
+    for( size_t y = 0; y < width; ++y )
+    {
+        factor[ y ] = (factor[ y ] - dotProduct( &matrix[ getIndex( 0, y, stride ) ], factor.data(), y ))
+                    / matrix[ getIndex( y, y, stride ) ];
+        for( size_t x = 0; x < y; ++x )
+        {
+            matrix[ getIndex( y, x, stride ) ] = matrix[ getIndex( x, y, stride ) ];
+        }
+    }
+}
+
+size_t mixedPrecisionSolve( const t_vector<double>& matrix, const t_vector<double>& factor,
+                            t_vector<double>& solution, size_t maxIterations )
+{
+    size_t width = factor.size();
+    size_t stride = matrix.size() / width;
+    t_vector<float> lu( matrix.begin(), matrix.end() );
+    t_indexVector permutation( width );
+    luFactor( lu, permutation );
+
+    double matrixNorm = 0;
+    for( size_t y = 0; y < width; ++y )
+    {
+        double rowNorm = 0;
+        for( size_t x = 0; x < width; ++x )
+        {
+            rowNorm += std::abs( matrix[ getIndex( x, y, stride ) ] );
+        }
+        matrixNorm = std::max( matrixNorm, rowNorm );
+    }
+
+    solution.assign( width, 0 );
+    t_vector<double> residual( factor );
+    t_vector<float> correction( width );
+    double lastNorm = std::numeric_limits<double>::max();
+
+    size_t iteration = 0;
+    while( iteration < maxIterations )
+    {
+        ++iteration;
+        std::copy( residual.begin(), residual.end(), correction.begin() );
+        luSolve( lu, permutation, correction );
+        for( size_t y = 0; y < width; ++y )
+        {
+            solution[ y ] += correction[ y ];
+        }
+
+        double residualNorm = 0;
+        double solutionNorm = 0;
+        for( size_t y = 0; y < width; ++y )
+        {
+            residual[ y ] = factor[ y ] - dotProduct( &matrix[ getIndex( 0, y, stride ) ], solution.data(), width );
+            residualNorm = std::max( residualNorm, std::abs( residual[ y ] ) );
+            solutionNorm = std::max( solutionNorm, std::abs( solution[ y ] ) );
+        }
+
+        // Stop at double accuracy, or when float is too coarse for this matrix to keep improving
+        double tolerance = std::numeric_limits<double>::epsilon() * std::sqrt( static_cast<double>( width ) )
+                         * matrixNorm * solutionNorm;
+        if( residualNorm <= tolerance || residualNorm > lastNorm / 2 )
+            break;
+        lastNorm = residualNorm;
+    }
+    return( iteration );
+}
+
+#define INSTANTIATE_SOLVERS( T ) \
+template void backSubstitution( const t_vector<T>& matrix, t_vector<T>& factor ); \
+template void backSubstitutionBlock( const t_vector<T>& matrix, t_vector<T>& factors, size_t rhsCount ); \
+template void pivotSimdTransform( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void luFactor( t_vector<T>& matrix, t_indexVector& permutation ); \
+template void luSolve( const t_vector<T>& lu, const t_indexVector& permutation, t_vector<T>& factor ); \
+template void luSolveBlock( const t_vector<T>& lu, const t_indexVector& permutation, t_vector<T>& factors, size_t rhsCount ); \
+template void luUpdate( t_vector<T>& lu, const t_indexVector& permutation, const t_vector<T>& x, const t_vector<T>& y, size_t rank ); \
+template void luReplaceRow( t_vector<T>& lu, const t_indexVector& permutation, size_t row, const t_vector<T>& values ); \
+template bool choleskyFactor( t_vector<T>& matrix, size_t width ); \
+template void choleskySolve( const t_vector<T>& l, t_vector<T>& factor ); \
+template void choleskySimdTransform( t_vector<T>& matrix, t_vector<T>& factor );
+
+INSTANTIATE_SOLVERS( float )
+INSTANTIATE_SOLVERS( double )
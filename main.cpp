@@ -21,14 +21,59 @@
  */
 //-----------------------------------------------------------------------------
 #include "boostSimd.h"
+#include "cpuDispatch.h"
+#include "benchmark.h"
+#include "numaSimd.h"
+#include "matrixFile.h"
+#include "layoutSimd.h"
+#include "solveService.h"
+#include "autoTune.h"
+#include "halfSimd.h"
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <cmath>
+#include <thread>
+#include <stdexcept>
+#include <xmmintrin.h>
+#include <pmmintrin.h>
 #include <boost/timer/timer.hpp>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif // _OPENMP
+
 void setupMatrix( t_dataVector& matrix );
+void setupBandedMatrix( t_dataVector& matrix, size_t width, size_t bandwidth );
 void printMatrix( const std::string& name, const t_dataVector& matrix, size_t width, size_t height );
+void benchmarkBatched( size_t width, size_t count, size_t loopCount );
+void benchmarkPrecision( size_t width, size_t loopCount );
+void benchmarkArena( size_t width, size_t loopCount );
+void benchmarkLayouts( const std::vector<size_t>& sizes, const BenchmarkOptions& options, unsigned seed,
+                       std::vector<BenchmarkResult>& results );
+void benchmarkBanded( const std::vector<size_t>& sizes, size_t bandwidth, const BenchmarkOptions& options,
+                      std::vector<BenchmarkResult>& results );
+int benchmarkService( const std::vector<size_t>& sizes, size_t clients, size_t requestsPerClient,
+                      size_t workers, size_t splitWidth );
+void benchmarkOutOfPlace( const std::vector<size_t>& sizes, const BenchmarkOptions& options, unsigned seed,
+                          std::vector<BenchmarkResult>& results );
+void benchmarkUpdate( const std::vector<size_t>& sizes, size_t rank, const BenchmarkOptions& options,
+                      std::vector<BenchmarkResult>& results );
+void benchmarkHalf( const std::vector<size_t>& sizes, const BenchmarkOptions& options,
+                    std::vector<BenchmarkResult>& results );
+int solveMatrixFile( const std::string& matrixPath, const std::string& factorPath, const std::string& solutionPath,
+                     size_t panelRows );
+void printUsage( const char* program );
+void printResult( const std::string& name, const BenchmarkResult& result, bool counters );
+void printCounters( const BenchmarkResult& result );
+std::vector<int> getNodesCpus( const std::vector<std::vector<int>>& nodes, size_t count );
+std::vector<size_t> parseSizes( const std::string& list );
 
-int main()
+int main( int argc, char* argv[] )
 {
     // Disable denormals
     // Requires #include <xmmintrin.h>
@@ -36,100 +81,1267 @@ int main()
     _MM_SET_FLUSH_ZERO_MODE( _MM_FLUSH_ZERO_ON );
     _MM_SET_DENORMALS_ZERO_MODE( _MM_DENORMALS_ZERO_ON );
 
-    size_t width = 768; // Always multiples of 16
-    size_t height = width; // Always a square matrix 
-
-    size_t loopCount = 200;
-
     struct Executions
     {
+        std::string id_;
         std::string name_;
-        void (*transform_)( t_dataVector& matrix, t_dataVector& factor );
+        t_transform transform_;
+        bool default_;
+        t_system system_ = t_system::dominant;  // system it is verified and timed on
     };
 
     Executions exec[] = {
-    { "Base",                       &simpleTransform },
-//    { "Unrolled",                   &unrolledTransform },
+    { "base",                       "Base",                             &simpleTransform,           true },
+    { "unrolled",                   "Unrolled",                         &unrolledTransform,         false },
 #ifdef _OPENMP
-//    { "OpenMP",                     &openMPTransform },
-//    { "OpenMP unrolled",            &unrolledOpenMPTransform },
+    { "openmp",                     "OpenMP",                           &openMPTransform,           false },
+    { "openmp-unrolled",            "OpenMP unrolled",                  &unrolledOpenMPTransform,   false },
 #endif // _OPENMP
 
-    { "Vectorized", &vectorizedTransform },
-//    { "Vectorized OpenMP", &vectorizedOpenMPTransform },
+    { "vectorized",                 "Vectorized",                       &vectorizedTransform,       true },
+#ifdef _OPENMP
+    { "vectorized-openmp",          "Vectorized OpenMP",                &vectorizedOpenMPTransform, false },
+#endif // _OPENMP
 
-    { "Boost.SIMD", &simdTransform },
-    { "Boost.SIMD with ranges", &simdTransform2 },
-    { "Boost.SIMD with transform", &simdTransform3 },
-//    { "Boost.SIMD unrolled",        &unrolledSimdTransform },
+    { "simd",                       "Boost.SIMD",                       &simdTransform,             true },
+    { "simd-scaled",                "Boost.SIMD precomputed scales",    &scaledSimdTransform,       true },
+    { "simd-fixed",                 "Boost.SIMD fixed size",            &fixedSimdTransform,        true },
+    { "simd-stream",                "Boost.SIMD streaming stores",      &streamSimdTransform,       false },
+    { "simd-ranges",                "Boost.SIMD with ranges",           &simdTransform2,            true },
+    { "simd-transform",             "Boost.SIMD with transform",        &simdTransform3,            true },
+    { "simd-unrolled",              "Boost.SIMD unrolled",              &unrolledSimdTransform,     false },
+    { "simd-blocked",               "Boost.SIMD blocked",               &blockedSimdTransform,      true },
+    { "simd-pivoting",              "Boost.SIMD pivoting",              &pivotSimdTransform,        true, t_system::general },
+    { "simd-sparse",                "Boost.SIMD zero pack skip",        &sparseSimdTransform,       false },
+    { "simd-cholesky",              "Boost.SIMD Cholesky (SPD)",        &choleskySimdTransform,     false, t_system::spd },
 #ifdef _OPENMP
-//    { "Boost.SIMD OpenMP",          &simdOpenMPTransform },
- //   { "Boost.SIMD OpenMP unrolled", &unrolledSimdOpenMPTransform },
+    { "simd-openmp",                "Boost.SIMD OpenMP",                &simdOpenMPTransform,       false },
+    { "simd-openmp-scaled",         "Boost.SIMD OpenMP precomputed scales", &scaledSimdOpenMPTransform, false },
+    { "simd-openmp-unrolled",       "Boost.SIMD OpenMP unrolled",       &unrolledSimdOpenMPTransform, false },
+    { "simd-numa",                  "Boost.SIMD OpenMP NUMA rows",      &numaSimdOpenMPTransform,   false },
+#ifdef BUILD_TASK_TRANSFORMS
+    { "simd-tasks",                 "Boost.SIMD OpenMP tasks",          &taskOpenMPTransform,       true },
+#endif // BUILD_TASK_TRANSFORMS
 #endif // _OPENMP
 
 #ifdef BUILD_INTRINSICS_TRANSFORMS
-    { "Intrinsics Float",           &intrinsicsTransformFloat },
-//    { "Intrinsics Float unrolled",  &unrolledIntrinsicsTransformFloat },
+    { "intrinsics",                 "Intrinsics Float",                 &intrinsicsTransformFloat,  true },
+    { "intrinsics-unrolled",        "Intrinsics Float unrolled",        &unrolledIntrinsicsTransformFloat, false },
 #ifdef _OPENMP
-//    { "Intrinsics Float OpenMP",    &intrinsicsOpenMPTransformFloat },
-//    { "Intrinsics Float OpenMP unrolled", &unrolledIntrinsicsOpenMPTransformFloat },
+    { "intrinsics-openmp",          "Intrinsics Float OpenMP",          &intrinsicsOpenMPTransformFloat, false },
+    { "intrinsics-openmp-unrolled", "Intrinsics Float OpenMP unrolled", &unrolledIntrinsicsOpenMPTransformFloat, false },
 #endif // _OPENMP
 #endif // BUILD_INTRINSICS_TRANSFORMS
 
-    { "", NULL } };
+    { "dispatch-simd",              "Dispatched packs",                 &dispatchSimdTransform,     true },
+    { "dispatch-intrinsics",        "Dispatched intrinsics",            &dispatchIntrinsicsTransform, true },
+    { "tuned",                      "Tuned for this host",              &tunedTransform,            false },
 
-    t_dataVector baseMatrix( width * height );
-    t_dataVector baseFactor( width );
+    { "", "", NULL, false } };
 
-    boost::timer::cpu_timer timer;
+    std::vector<size_t> sizes;
+    size_t minSize = 64;
+    size_t maxSize = 2048;
+    BenchmarkOptions options;
+    std::string csvPath, jsonPath;
+    std::vector<std::string> selected;
+    bool runBatched = false;
+    bool runPrecision = false;
+    bool runArena = false;
+    bool runLayouts = false;
+    bool runOutOfPlace = false;
+    bool tune = false;
+    size_t updateRank = 0;
+    bool runHalf = false;
+    std::string tuningPath = getTuningPath();
+    size_t bandwidth = 0;
+    size_t serviceClients = 0;
+    size_t serviceRequests = 64;
+    size_t serviceThreads = std::max( std::thread::hardware_concurrency(), 2u );
+    size_t serviceSplit = 512;
+    std::string matrixPath, factorPath, solutionPath;
+    size_t generateWidth = 0;
+    size_t panelRows = 0;
+    size_t prefetchLines = 8;
+    size_t streamThreshold = 32 * 1024 * 1024;
+    size_t verifyCount = 8;
+    unsigned verifySeed = std::random_device()();
+    bool verifyOnly = false;
+    bool numa = false;
+    bool numaScaling = false;
+
+    for( int i = 1; i < argc; ++i )
+    {
+        std::string arg = argv[ i ];
+        bool hasValue = i + 1 < argc;
+        if( arg == "--sizes" && hasValue )          sizes = parseSizes( argv[ ++i ] );
+        else if( arg == "--min-size" && hasValue )  minSize = std::stoul( argv[ ++i ] );
+        else if( arg == "--max-size" && hasValue )  maxSize = std::stoul( argv[ ++i ] );
+        else if( arg == "--samples" && hasValue )   options.samples_ = std::stoul( argv[ ++i ] );
+        else if( arg == "--budget" && hasValue )    options.budget_ = std::stod( argv[ ++i ] );
+        else if( arg == "--csv" && hasValue )       csvPath = argv[ ++i ];
+        else if( arg == "--json" && hasValue )      jsonPath = argv[ ++i ];
+        else if( arg == "--verify" && hasValue )    verifyCount = std::stoul( argv[ ++i ] );
+        else if( arg == "--seed" && hasValue )      verifySeed = static_cast<unsigned>( std::stoul( argv[ ++i ] ) );
+        else if( arg == "--numa" )                  numa = true;
+        else if( arg == "--numa-scaling" )          numaScaling = true;
+        else if( arg == "--counters" )              options.counters_ = true;
+        else if( arg == "--verify-only" )           verifyOnly = true;
+        else if( arg == "--batched" )               runBatched = true;
+        else if( arg == "--precision" )             runPrecision = true;
+        else if( arg == "--prefetch" && hasValue )  prefetchLines = std::stoul( argv[ ++i ] );
+        else if( arg == "--stream-threshold" && hasValue ) streamThreshold = std::stoul( argv[ ++i ] );
+        else if( arg == "--matrix" && hasValue )    matrixPath = argv[ ++i ];
+        else if( arg == "--factor" && hasValue )    factorPath = argv[ ++i ];
+        else if( arg == "--solution" && hasValue )  solutionPath = argv[ ++i ];
+        else if( arg == "--generate" && hasValue )  generateWidth = std::stoul( argv[ ++i ] );
+        else if( arg == "--out-of-core" && hasValue ) panelRows = std::stoul( argv[ ++i ] );
+        else if( arg == "--arena-benchmark" )       runArena = true;
+        else if( arg == "--layouts" )               runLayouts = true;
+        else if( arg == "--out-of-place" )          runOutOfPlace = true;
+        else if( arg == "--tune" )                  tune = true;
+        else if( arg == "--tuning" && hasValue )    tuningPath = argv[ ++i ];
+        else if( arg == "--banded" && hasValue )    bandwidth = std::stoul( argv[ ++i ] );
+        else if( arg == "--update" && hasValue )    updateRank = std::stoul( argv[ ++i ] );
+        else if( arg == "--half" )                  runHalf = true;
+        else if( arg == "--service" && hasValue )   serviceClients = std::stoul( argv[ ++i ] );
+        else if( arg == "--service-requests" && hasValue ) serviceRequests = std::stoul( argv[ ++i ] );
+        else if( arg == "--service-threads" && hasValue ) serviceThreads = std::stoul( argv[ ++i ] );
+        else if( arg == "--service-split" && hasValue ) serviceSplit = std::stoul( argv[ ++i ] );
+        else if( arg == "--arena" && hasValue )
+        {
+            std::string mode = argv[ ++i ];
+            t_arenaMode modes[] = { t_arenaMode::aligned, t_arenaMode::pool, t_arenaMode::transparentHuge, t_arenaMode::explicitHuge };
+            auto found = std::find_if( std::begin( modes ), std::end( modes ), [&]( t_arenaMode m ) { return mode == getArenaModeName( m ); } );
+            if( found == std::end( modes ) )
+            {
+                printUsage( argv[ 0 ] );
+                return 1;
+            }
+            setArenaMode( *found );
+        }
+        else if( arg == "--list" )
+        {
+            for( size_t index = 0; exec[index].transform_; ++index )
+            {
+                std::cout << std::left << std::setw( 28 ) << exec[index].id_ << exec[index].name_
+                          << (exec[index].default_ ? "" : " (not run by default)") << std::endl;
+            }
+            return 0;
+        }
+        else if( arg.compare( 0, 2, "--" ) == 0 )
+        {
+            printUsage( argv[ 0 ] );
+            return 1;
+        }
+        else
+        {
+            selected.push_back( arg );
+        }
+    }
+
+    if( sizes.empty() )
+    {
+        for( size_t size = minSize; size <= maxSize; size *= 2 )
+        {
+            sizes.push_back( size );
+        }
+    }
+
+    std::vector<const Executions*> runs;
+    for( size_t index = 0; exec[index].transform_; ++index )
+    {
+        bool wanted = selected.empty() ? exec[index].default_
+                    : std::find( selected.begin(), selected.end(), exec[index].id_ ) != selected.end()
+                      || std::find( selected.begin(), selected.end(), "all" ) != selected.end();
+        if( wanted )
+            runs.push_back( &exec[index] );
+    }
+    for( const std::string& id : selected )
+    {
+        if( id != "all" && std::none_of( runs.begin(), runs.end(), [&]( const Executions* run ) { return run->id_ == id; } ) )
+        {
+            std::cerr << "Unknown variant: " << id << " (see --list)" << std::endl;
+            return 1;
+        }
+    }
+
+    std::string isa = getIsaName( detectIsa() );
+    std::cout << "Dispatch ISA: " << isa << std::endl << std::endl;
+
+    setStreamTuning( prefetchLines, streamThreshold );
+
+    if( !matrixPath.empty() )
+    {
+        if( factorPath.empty() )
+        {
+            printUsage( argv[ 0 ] );
+            return 1;
+        }
+        try
+        {
+            if( generateWidth )
+                writeRandomSystem( matrixPath, factorPath, generateWidth, verifySeed );
+            return solveMatrixFile( matrixPath, factorPath, solutionPath, panelRows );
+        }
+        catch( const std::exception& error )
+        {
+            std::cerr << error.what() << std::endl;
+            return 1;
+        }
+    }
+
+    // Quick timings are enough to rank the kernels
+    BenchmarkOptions tuneOptions;
+    tuneOptions.samples_ = 5;
+    tuneOptions.budget_ = 0.25;
+    if( tune )
+    {
+        writeTuning( tuningPath, autoTune( sizes, tuneOptions, &std::cout ) );
+        std::cout << "Tuning written to " << tuningPath << std::endl;
+        return 0;
+    }
+    if( std::any_of( runs.begin(), runs.end(), []( const Executions* run ) { return run->id_ == "tuned"; } ) )
+    {
+        loadTuning( tuningPath, sizes, tuneOptions, &std::cout );
+        std::cout << std::endl;
+    }
+
+    if( serviceClients )
+        return( benchmarkService( sizes, serviceClients, serviceRequests, serviceThreads, serviceSplit ) );
+
+    std::vector<std::vector<int>> nodes = getNumaNodes();
+#ifdef _OPENMP
+    if( numa )
+    {
+        // One thread per CPU, alternating nodes, and matrix rows on their owner's node
+        std::vector<int> cpus = getNodesCpus( nodes, nodes.size() );
+        omp_set_num_threads( static_cast<int>( cpus.size() ) );
+        pinThreads( cpus );
+        options.prepare_ = &distributeRows<t_dataType>;
+        std::cout << "NUMA: " << nodes.size() << " nodes, " << cpus.size() << " pinned threads" << std::endl << std::endl;
+    }
+#endif // _OPENMP
+
+    // Check every selected variant on random widths before timing anything, a
+    // variant that fails is reported and left out of the benchmark
+    int status = 0;
+    if( verifyCount )
+    {
+        std::mt19937 generator( verifySeed );
+        std::uniform_int_distribution<size_t> widthDistribution( 2, 300 );
+        std::vector<std::pair<size_t, unsigned>> checks;
+        for( size_t i = 0; i < verifyCount; ++i )
+        {
+            // Each random width and the next multiple of the widest pack
+            size_t width = widthDistribution( generator );
+            checks.emplace_back( width, static_cast<unsigned>( generator() ) );
+            if( width % 16 )
+                checks.emplace_back( (width + 15) & ~static_cast<size_t>( 15 ), static_cast<unsigned>( generator() ) );
+        }
+
+        std::cout << "Verifying " << verifyCount << " random systems per variant, seed " << verifySeed << std::endl;
+        auto report = [&]( const std::string& name, const VerifyResult& result )
+        {
+            if( result.passed_ )
+                return( false );
+            std::cout << name << " FAILED width " << result.width_ << ( result.padded_ ? " padded" : "" )
+                      << " seed " << result.seed_ << " - ";
+            if( !result.failure_.empty() )
+                std::cout << result.failure_ << std::endl;
+            else
+                std::cout << "error " << std::scientific << std::setprecision( 3 ) << result.error_
+                          << " > " << result.tolerance_ << std::endl;
+            return( true );
+        };
+        auto failed = [&]( const Executions* run )
+        {
+            for( const auto& check : checks )
+            {
+                // Rows width apart and, where that differs, getStride apart
+                VerifyResult result = verifyTransform( run->transform_, check.first, check.second, run->system_ );
+                if( result.passed_ && getStride<t_dataType>( check.first ) != check.first )
+                    result = verifyTransform( run->transform_, check.first, check.second, run->system_, true );
+                if( report( run->name_, result ) )
+                    return( true );
+            }
+            return( false );
+        };
+        auto end = std::remove_if( runs.begin(), runs.end(), failed );
+        if( end != runs.end() )
+            status = 1;
+        runs.erase( end, runs.end() );
+
+        // The solve service splitting each width across its workers
+        for( const auto& check : checks )
+        {
+            if( report( "SolveService split", verifySolveService( check.first, check.second ) ) )
+            {
+                status = 1;
+                break;
+            }
+        }
+        std::cout << std::endl;
+    }
+    if( verifyOnly )
+        return status;
 
     srand( time(NULL) ); // To debug put a constant here
-    setupMatrix( baseMatrix );
-    setupMatrix( baseFactor );
 
-    printMatrix( "Matrix", baseMatrix, width, height );
-    printMatrix( "Factors", baseFactor, width, 1 );
+    std::vector<BenchmarkResult> results;
+    for( size_t width : sizes )
+    {
+        size_t height = width; // Always a square matrix
+        t_dataVector baseMatrix( width * height );
+        t_dataVector baseFactor( width );
+        setupMatrix( baseMatrix );
+        setupMatrix( baseFactor );
+
+        printMatrix( "Matrix", baseMatrix, width, height );
+        printMatrix( "Factors", baseFactor, width, 1 );
+
+        // Same size system for the variants that need it symmetric positive definite
+        t_dataVector spdMatrix;
+        if( std::any_of( runs.begin(), runs.end(), []( const Executions* run ) { return run->system_ == t_system::spd; } ) )
+        {
+            spdMatrix.resize( width * height );
+            setupSpdMatrix( spdMatrix, width, static_cast<unsigned>( rand() ) );
+        }
+
+        for( const Executions* run : runs )
+        {
+            try
+            {
+                BenchmarkResult result = runBenchmark( run->id_, run->transform_, run->system_ == t_system::spd ? spdMatrix : baseMatrix, baseFactor, options );
+                results.push_back( result );
+                printResult( run->name_, result, options.counters_ );
+            }
+            catch( const std::domain_error& error )
+            {
+                std::cout << run->name_ << " FAILED width " << width << " - " << error.what() << std::endl;
+                status = 1;
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    if( runLayouts )
+        benchmarkLayouts( sizes, options, verifySeed, results );
+    if( bandwidth )
+        benchmarkBanded( sizes, bandwidth, options, results );
+    if( runOutOfPlace )
+        benchmarkOutOfPlace( sizes, options, verifySeed, results );
+    if( updateRank )
+        benchmarkUpdate( sizes, updateRank, options, results );
+    if( runHalf )
+        benchmarkHalf( sizes, options, results );
 
-    size_t index = 0;
-    while( exec[index].transform_ )
+#ifdef _OPENMP
+    if( numaScaling )
     {
-        t_dataVector matrix( baseMatrix );
-        t_dataVector factor( baseFactor );
+        // NUMA row kernel at the largest width on the CPUs of 1, 2, ... nodes,
+        // rows placed on their owner's node each time
+        size_t width = sizes.back();
+        t_dataVector baseMatrix( width * width );
+        t_dataVector baseFactor( width );
+        setupMatrix( baseMatrix );
+        setupMatrix( baseFactor );
 
-        // Warmup (fill cache, create OpenMP threads, etc).
-        exec[index].transform_( matrix, factor );
+        BenchmarkOptions scalingOptions = options;
+        scalingOptions.prepare_ = &distributeRows<t_dataType>;
+        double baseGflops = 0;
+        for( size_t count = 1; count <= nodes.size(); ++count )
+        {
+            std::vector<int> cpus = getNodesCpus( nodes, count );
+            omp_set_num_threads( static_cast<int>( cpus.size() ) );
+            pinThreads( cpus );
 
-        timer.start();
-        for(size_t i = 0; i < loopCount; ++i )
+            std::string name = "simd-numa/nodes=" + std::to_string( count );
+            BenchmarkResult result = runBenchmark( name, &numaSimdOpenMPTransform<t_dataType>, baseMatrix, baseFactor, scalingOptions );
+            results.push_back( result );
+            printResult( name + " (" + std::to_string( cpus.size() ) + " threads)", result, options.counters_ );
+
+            if( count == 1 )
+                baseGflops = result.gflops_;
+            std::cout << std::string( 46, ' ' ) << "speedup over one node " << std::fixed << std::setprecision( 2 )
+                      << result.gflops_ / baseGflops << std::endl;
+        }
+        std::cout << std::endl;
+    }
+#endif // _OPENMP
+
+    if( !csvPath.empty() )
+    {
+        if( csvPath == "-" )
         {
-            matrix = baseMatrix;
-            factor = baseFactor;
-            exec[index].transform_( matrix, factor );
+            writeCsv( std::cout, results );
         }
-        timer.stop();
-        printMatrix( "Matrix", matrix, width, height );
-        printMatrix( "Factors", factor, width, 1 );
+        else
+        {
+            std::ofstream csv( csvPath );
+            writeCsv( csv, results );
+        }
+    }
+    if( !jsonPath.empty() )
+    {
+        if( jsonPath == "-" )
+        {
+            writeJson( std::cout, results, isa );
+        }
+        else
+        {
+            std::ofstream json( jsonPath );
+            writeJson( json, results, isa );
+        }
+    }
+
+    if( runBatched )
+        benchmarkBatched( 16, 100000, 10 );
+    if( runPrecision )
+        benchmarkPrecision( 768, 20 );
+    if( runArena )
+        benchmarkArena( sizes.back(), 10 );
+    return status;
+}
+
+void printUsage( const char* program )
+{
+    std::cerr << "Usage: " << program << " [options] [variant ...]" << std::endl
+              << "  --list              list the variant names, all selects every variant" << std::endl
+              << "  --sizes a,b,c       widths to run (default: powers of two from --min-size to --max-size)" << std::endl
+              << "  --min-size n        smallest width of the sweep (default 64)" << std::endl
+              << "  --max-size n        largest width of the sweep (default 2048)" << std::endl
+              << "  --samples n         timed runs per variant and width (default 15)" << std::endl
+              << "  --budget s          seconds per variant and width before stopping early, min 3 runs (default 2)" << std::endl
+              << "  --csv file          write the results as CSV, - for stdout" << std::endl
+              << "  --json file         write the results as JSON, - for stdout" << std::endl
+              << "  --verify n          random systems each variant is checked on before timing, 0 to skip (default 8)" << std::endl
+              << "  --seed n            seed of the verification systems (default random, printed)" << std::endl
+              << "  --verify-only       stop after the verification" << std::endl
+              << "  --numa              pin one thread per CPU across the NUMA nodes and place matrix rows on their owner's node" << std::endl
+              << "  --numa-scaling      time simd-numa at the largest width on 1, 2, ... nodes" << std::endl
+              << "  --counters          record cycles, instructions, cache misses and FP vector instructions (Linux perf)" << std::endl
+              << "  --prefetch n        cache lines simd-stream prefetches ahead (default 8)" << std::endl
+              << "  --stream-threshold n  matrix bytes from which simd-stream streams, simdTransform below (default 32 MB)" << std::endl
+              << "  --matrix file       solve the raw row major matrix in file instead of benchmarking, needs --factor" << std::endl
+              << "  --factor file       raw right-hand side of --matrix, its length is the width" << std::endl
+              << "  --solution file     write the solution of --matrix there" << std::endl
+              << "  --generate n        first write a random n x n system to --matrix and --factor" << std::endl
+              << "  --out-of-core rows  eliminate --matrix in place on disk, rows per panel in memory" << std::endl
+              << "  --service clients   instead of benchmarking, load the solve service from that many client threads," << std::endl
+              << "                      each request a system of one of the --sizes widths" << std::endl
+              << "  --service-requests n  requests per client (default 64)" << std::endl
+              << "  --service-threads n workers of the service (default the hardware threads, at least 2)" << std::endl
+              << "  --service-split n   width from which idle workers join a system (default 512)" << std::endl
+              << "  --tune              time the kernels and their parameters at each width, write the winners and stop" << std::endl
+              << "  --tuning file       tuning file of the tuned variant, tuned first when missing (default ./boostSimdTuning.<host>)" << std::endl
+              << "  --arena mode        matrix buffers: aligned (default), pool, thp or hugetlb" << std::endl
+              << "  --arena-benchmark   compare the arena modes on setup time and dTLB misses at the largest width" << std::endl
+              << "  --banded n          also time the dense, zero pack skip and banded kernels on systems of bandwidth n" << std::endl
+              << "  --update k          also time a rank k update of an LU factorization against a new simdTransform" << std::endl
+              << "  --half              also time fp16 and bf16 matrix storage against float and report their accuracy" << std::endl
+              << "  --out-of-place      also time a copy then simdTransform against the out of place form that fuses the copy" << std::endl
+              << "  --layouts           also time simdTransform and its OpenMP variant on row major, column major and tiled matrices" << std::endl
+              << "  --batched           also run the batched small systems benchmark" << std::endl
+              << "  --precision         also run the mixed precision benchmark" << std::endl;
+}
+
+void printResult( const std::string& name, const BenchmarkResult& result, bool counters )
+{
+    std::cout << std::left << std::setw( 40 ) << name << std::right << std::setw( 6 ) << result.width_
+              << " - " << std::setw( 3 ) << result.samples_ << " runs"
+              << std::scientific << std::setprecision( 3 )
+              << " - min " << result.min_ << "s median " << result.median_ << "s p95 " << result.p95_ << "s"
+              << std::fixed << std::setprecision( 2 )
+              << " - " << result.gflops_ << " GFLOP/s " << result.gbytes_ << " GB/s"
+              << std::endl;
+    if( counters )
+        printCounters( result );
+}
+
+// CPUs of the first count nodes, alternating between nodes so any thread count spreads evenly
+std::vector<int> getNodesCpus( const std::vector<std::vector<int>>& nodes, size_t count )
+{
+    std::vector<int> cpus;
+    for( size_t i = 0; ; ++i )
+    {
+        bool added = false;
+        for( size_t node = 0; node < count; ++node )
+        {
+            if( i < nodes[ node ].size() )
+            {
+                cpus.push_back( nodes[ node ][ i ] );
+                added = true;
+            }
+        }
+        if( !added )
+            break;
+    }
+    return( cpus );
+}
+
+void printCounters( const BenchmarkResult& result )
+{
+    auto get = [&]( t_counter counter ) { return( result.counters_[ static_cast<size_t>( counter ) ] ); };
+    auto print = [&]( const char* name, double value )
+    {
+        std::cout << " " << name << " ";
+        if( std::isnan( value ) )
+            std::cout << "n/a";
+        else
+            std::cout << value;
+    };
+
+    // Per run, flop/cycle and flop/byte place the kernel on the roofline
+    double cycles = get( t_counter::cycles );
+    std::cout << std::string( 46, ' ' ) << std::scientific << std::setprecision( 3 );
+    print( "cycles", cycles );
+    print( "instr", get( t_counter::instructions ) );
+    print( "L1d miss", get( t_counter::l1Misses ) );
+    print( "LLC miss", get( t_counter::llcMisses ) );
+    print( "dTLB miss", get( t_counter::dtlbMisses ) );
+    print( "FP vec", get( t_counter::fpVector ) );
+    std::cout << std::fixed << std::setprecision( 2 );
+    print( "IPC", get( t_counter::instructions ) / cycles );
+    print( "flop/cycle", getEliminationFlops( result.width_ ) / cycles );
+    std::cout << std::endl;
+}
+
+std::vector<size_t> parseSizes( const std::string& list )
+{
+    std::vector<size_t> sizes;
+    std::istringstream stream( list );
+    std::string item;
+    while( std::getline( stream, item, ',' ) )
+    {
+        sizes.push_back( std::stoul( item ) );
+    }
+    return( sizes );
+}
 
+void setupMatrix( t_dataVector& matrix )
+{
+    std::generate( matrix.begin( ), matrix.end( ), &rand );
+}
+
+// Random within the band, diagonally dominant so no pivoting is needed
+void setupBandedMatrix( t_dataVector& matrix, size_t width, size_t bandwidth )
+{
+    setupMatrix( matrix );
+    for( size_t y = 0; y < width; ++y )
+    {
+        t_dataType* pLine = &( matrix[ getIndex( 0, y, width ) ] );
+        t_dataType sum = 0;
+        for( size_t x = 0; x < width; ++x )
+        {
+            if( x + bandwidth < y || y + bandwidth < x )
+                pLine[ x ] = 0;
+            sum += std::abs( pLine[ x ] );
+        }
+        pLine[ y ] = sum;
+    }
+}
+
+void benchmarkBatched( size_t width, size_t count, size_t loopCount )
+{
+    size_t size = width * width;
+    t_dataVector baseMatrices( count * size );
+    t_dataVector baseFactors( count * width );
+    setupMatrix( baseMatrices );
+    setupMatrix( baseFactors );
+
+    boost::timer::cpu_timer timer;
+    auto report = [&]( const std::string& name )
+    {
         double seconds = static_cast<double>(timer.elapsed().wall) / 1000000000.0;
-        double matrixPerSecond = loopCount / seconds;
-        double kflops = static_cast<double>(width*(width + 2) + 2 * width)/ 1000.0 / seconds ;
+        double systemsPerSecond = static_cast<double>(loopCount * count) / seconds;
 
-        std::cout << exec[index].name_ << " time: " 
+        std::cout << name << " " << count << " systems " << width << "x" << width << " time: "
                   << timer.format( boost::timer::default_places, "%ws wall, %us user + %ss system = %ts CPU (%p%)" )
-                  << " - " << std::fixed << std::setprecision(6) << matrixPerSecond << " matrix/s"
-                  << " - " << std::fixed << std::setprecision(2) << kflops << " kflops"
+                  << " - " << std::fixed << std::setprecision(0) << systemsPerSecond << " systems/s"
                   << std::endl << std::endl;
+    };
+
+    // One simdTransform call per system
+    t_dataVector matrix( size );
+    t_dataVector factor( width );
+    timer.start();
+    for( size_t i = 0; i < loopCount; ++i )
+    {
+        for( size_t system = 0; system < count; ++system )
+        {
+            std::copy_n( baseMatrices.begin() + system * size, size, matrix.begin() );
+            std::copy_n( baseFactors.begin() + system * width, width, factor.begin() );
+            simdTransform( matrix, factor );
+        }
+    }
+    timer.stop();
+    report( "Boost.SIMD per system" );
+
+    // All systems interleaved, one per pack lane
+    t_dataVector batchMatrices, batchFactors;
+    t_dataVector interleavedMatrices, interleavedFactors;
+    interleaveBatch( baseMatrices, interleavedMatrices, size );
+    interleaveBatch( baseFactors, interleavedFactors, width );
+    timer.start();
+    for( size_t i = 0; i < loopCount; ++i )
+    {
+        batchMatrices = interleavedMatrices;
+        batchFactors = interleavedFactors;
+        batchedSimdTransform( batchMatrices, batchFactors, width );
+    }
+    timer.stop();
+    report( "Boost.SIMD batched" );
+}
+
+// Mapped in place, private copy on write pages when the matrix fits in memory,
+// shared with the file and streamed a panel at a time when out of core
+int solveMatrixFile( const std::string& matrixPath, const std::string& factorPath, const std::string& solutionPath,
+                     size_t panelRows )
+{
+    t_dataVector baseFactor = readVectorFile( factorPath );
+    t_dataVector factor( baseFactor );
+    size_t width = factor.size();
+
+    boost::timer::cpu_timer timer;
+    {
+        MappedMatrix matrix( matrixPath, width, panelRows != 0 );
+        std::cout << "Matrix " << matrixPath << ": " << width << "x" << width << ", stride " << matrix.stride()
+                  << (panelRows ? ", out of core panels of " + std::to_string( panelRows ) + " rows" : std::string()) << std::endl;
+
+        timer.start();
+        if( panelRows )
+            outOfCoreTransform( matrix, factor, panelRows );
+        else
+            dispatchSimdTransform( matrix.data(), factor.data(), width, matrix.stride() );
+        outOfCoreBackSubstitution( matrix, factor );
+        timer.stop();
+    }
+    std::cout << "Solve time: " << timer.format( boost::timer::default_places, "%ws wall, %us user + %ss system = %ts CPU (%p%)" )
+              << std::endl;
 
-        ++index;
+    // The out of core elimination overwrote the file, the in memory one left it as it was
+    if( !panelRows )
+    {
+        MappedMatrix matrix( matrixPath, width, false );
+        double residual = 0;
+        for( size_t y = 0; y < width; ++y )
+        {
+            const t_dataType* pLine = matrix.row( y );
+            double sum = 0;
+            for( size_t x = 0; x < width; ++x )
+            {
+                sum += static_cast<double>( pLine[ x ] ) * factor[ x ];
+            }
+            residual = std::max( residual, std::abs( sum - baseFactor[ y ] ) );
+            matrix.dontNeed( y, 1 );
+        }
+        std::cout << "Residual: " << std::scientific << std::setprecision( 3 ) << residual << std::endl;
     }
+
+    if( !solutionPath.empty() )
+        writeVectorFile( solutionPath, factor );
     return 0;
 }
 
-void setupMatrix( t_dataVector& matrix )
+// Copy then transform in place, what callers that keep their input do
+template< void (*transform)( t_dataVector&, t_dataVector& ) >
+void copyThenTransform( const t_dataVector& source, t_dataVector& matrix, t_dataVector& factor )
 {
-    std::generate( matrix.begin( ), matrix.end( ), &rand );
+    std::copy( source.begin(), source.end(), matrix.begin() );
+    transform( matrix, factor );
+}
+
+// Out of place transform with the in place signature, for verifyTransform
+template< void (*transform)( const t_dataVector&, t_dataVector&, t_dataVector& ) >
+void outOfPlaceTransform( t_dataVector& matrix, t_dataVector& factor )
+{
+    t_dataVector result( matrix.size() );
+    transform( matrix, result, factor );
+    matrix.swap( result );
+}
+
+// Both time the whole solve from an untouched input
+void benchmarkOutOfPlace( const std::vector<size_t>& sizes, const BenchmarkOptions& options, unsigned seed,
+                          std::vector<BenchmarkResult>& results )
+{
+    struct CopyRun
+    {
+        std::string id_;
+        std::string name_;
+        t_copyTransform transform_;
+        t_transform verify_;
+    };
+    std::vector<CopyRun> copyRuns = {
+        { "copy/simd",          "Boost.SIMD copy then in place",    &copyThenTransform<&simdTransform<t_dataType>>,
+          &simdTransform<t_dataType> },
+        { "fused/simd",         "Boost.SIMD out of place",          &simdTransform<t_dataType>,
+          &outOfPlaceTransform<&simdTransform<t_dataType>> },
+#ifdef _OPENMP
+        { "copy/simd-openmp",   "Boost.SIMD OpenMP copy then in place", &copyThenTransform<&simdOpenMPTransform<t_dataType>>,
+          &simdOpenMPTransform<t_dataType> },
+        { "fused/simd-openmp",  "Boost.SIMD OpenMP out of place",   &simdOpenMPTransform<t_dataType>,
+          &outOfPlaceTransform<&simdOpenMPTransform<t_dataType>> },
+#endif // _OPENMP
+    };
+
+    auto failed = [&]( const CopyRun& run )
+    {
+        VerifyResult result = verifyTransform( run.verify_, 203, seed );
+        if( !result.passed_ )
+        {
+            std::cout << run.name_ << " FAILED width " << result.width_ << " seed " << result.seed_
+                      << " - error " << std::scientific << std::setprecision( 3 ) << result.error_
+                      << " > " << result.tolerance_ << std::endl;
+        }
+        return( !result.passed_ );
+    };
+    copyRuns.erase( std::remove_if( copyRuns.begin(), copyRuns.end(), failed ), copyRuns.end() );
+
+    for( size_t width : sizes )
+    {
+        t_dataVector baseMatrix( width * getStride<t_dataType>( width ) );
+        t_dataVector baseFactor( width );
+        setupMatrix( baseMatrix );
+        setupMatrix( baseFactor );
+
+        for( const CopyRun& run : copyRuns )
+        {
+            BenchmarkResult result = runCopyBenchmark( run.id_, run.transform_, baseMatrix, baseFactor, options );
+            results.push_back( result );
+            printResult( run.name_, result, options.counters_ );
+        }
+        std::cout << std::endl;
+    }
+}
+
+// Row major in and out, for verifyTransform
+template< typename Layout, bool parallel >
+void convertedLayoutTransform( t_dataVector& matrix, t_dataVector& factor )
+{
+    size_t width = factor.size();
+    t_dataVector layoutMatrix;
+    toLayout<t_dataType, Layout>( matrix, layoutMatrix, width );
+#ifdef _OPENMP
+    if( parallel )
+        layoutSimdOpenMPTransform<t_dataType, Layout>( layoutMatrix, factor );
+    else
+#endif // _OPENMP
+        layoutSimdTransform<t_dataType, Layout>( layoutMatrix, factor );
+    fromLayout<t_dataType, Layout>( layoutMatrix, matrix, width );
+}
+
+// Each layout's kernels timed on a matrix already converted, the conversion
+// stays out of the measurement
+void benchmarkLayouts( const std::vector<size_t>& sizes, const BenchmarkOptions& options, unsigned seed,
+                       std::vector<BenchmarkResult>& results )
+{
+    struct LayoutRun
+    {
+        std::string id_;
+        std::string name_;
+        t_transform transform_;
+        t_transform converted_;
+        void (*toLayout_)( const t_dataVector&, t_dataVector&, size_t );
+    };
+    std::vector<LayoutRun> layoutRuns = {
+        { "layout-row/simd",        "Boost.SIMD row major",             &layoutSimdTransform<t_dataType, RowMajorLayout>,
+          &convertedLayoutTransform<RowMajorLayout, false>,             &toLayout<t_dataType, RowMajorLayout> },
+        { "layout-column/simd",     "Boost.SIMD column major",          &layoutSimdTransform<t_dataType, ColumnMajorLayout>,
+          &convertedLayoutTransform<ColumnMajorLayout, false>,          &toLayout<t_dataType, ColumnMajorLayout> },
+        { "layout-tiled/simd",      "Boost.SIMD tiled",                 &layoutSimdTransform<t_dataType, TiledLayout>,
+          &convertedLayoutTransform<TiledLayout, false>,                &toLayout<t_dataType, TiledLayout> },
+#ifdef _OPENMP
+        { "layout-row/openmp",      "Boost.SIMD OpenMP row major",      &layoutSimdOpenMPTransform<t_dataType, RowMajorLayout>,
+          &convertedLayoutTransform<RowMajorLayout, true>,              &toLayout<t_dataType, RowMajorLayout> },
+        { "layout-column/openmp",   "Boost.SIMD OpenMP column major",   &layoutSimdOpenMPTransform<t_dataType, ColumnMajorLayout>,
+          &convertedLayoutTransform<ColumnMajorLayout, true>,           &toLayout<t_dataType, ColumnMajorLayout> },
+        { "layout-tiled/openmp",    "Boost.SIMD OpenMP tiled",          &layoutSimdOpenMPTransform<t_dataType, TiledLayout>,
+          &convertedLayoutTransform<TiledLayout, true>,                 &toLayout<t_dataType, TiledLayout> },
+#endif // _OPENMP
+    };
+
+    auto failed = [&]( const LayoutRun& run )
+    {
+        VerifyResult result = verifyTransform( run.converted_, 203, seed );
+        if( !result.passed_ )
+        {
+            std::cout << run.name_ << " FAILED width " << result.width_ << " seed " << result.seed_
+                      << " - error " << std::scientific << std::setprecision( 3 ) << result.error_
+                      << " > " << result.tolerance_ << std::endl;
+        }
+        return( !result.passed_ );
+    };
+    layoutRuns.erase( std::remove_if( layoutRuns.begin(), layoutRuns.end(), failed ), layoutRuns.end() );
+
+    for( size_t width : sizes )
+    {
+        t_dataVector rowMatrix( width * width );
+        t_dataVector baseFactor( width );
+        setupMatrix( rowMatrix );
+        setupMatrix( baseFactor );
+
+        for( const LayoutRun& run : layoutRuns )
+        {
+            t_dataVector baseMatrix;
+            run.toLayout_( rowMatrix, baseMatrix, width );
+            BenchmarkResult result = runBenchmark( run.id_, run.transform_, baseMatrix, baseFactor, options );
+            results.push_back( result );
+            printResult( run.name_, result, options.counters_ );
+        }
+        std::cout << std::endl;
+    }
+}
+
+// Banded systems in dense storage for simdTransform and the zero pack skip, in
+// banded storage for the banded kernel. The GFLOP/s still count the dense work.
+void benchmarkBanded( const std::vector<size_t>& sizes, size_t bandwidth, const BenchmarkOptions& options,
+                      std::vector<BenchmarkResult>& results )
+{
+    for( size_t width : sizes )
+    {
+        t_dataVector baseMatrix( width * width );
+        t_dataVector baseFactor( width );
+        setupBandedMatrix( baseMatrix, width, bandwidth );
+        setupMatrix( baseFactor );
+
+        size_t lower, upper;
+        getBandwidth( baseMatrix, width, lower, upper );
+        t_dataVector baseBand;
+        toBand( baseMatrix, baseBand, width, lower, upper );
+
+        // The banded solution against the input system
+        t_dataVector band( baseBand );
+        t_dataVector solution( baseFactor );
+        bandedSimdTransform( band, solution, lower, upper );
+        bandedBackSubstitution( band, solution, lower, upper );
+        std::cout << "Banded " << width << "x" << width << " bandwidth " << bandwidth << " - backward error "
+                  << std::scientific << std::setprecision( 3 ) << getBackwardError( baseMatrix, baseFactor, solution ) << std::endl;
+
+        auto bandedTransform = [lower, upper]( t_dataVector& band, t_dataVector& factor )
+        {
+            bandedSimdTransform( band, factor, lower, upper );
+        };
+        struct BandedRun
+        {
+            std::string id_;
+            std::string name_;
+            t_transformFunction transform_;
+            const t_dataVector& matrix_;
+        };
+        BandedRun bandedRuns[] = {
+            { "banded/simd",        "Boost.SIMD dense storage",     t_transform( &simdTransform<t_dataType> ), baseMatrix },
+            { "banded/simd-sparse", "Boost.SIMD zero pack skip",    &sparseSimdTransform<t_dataType>,   baseMatrix },
+            { "banded/simd-banded", "Boost.SIMD banded storage",    bandedTransform,                    baseBand } };
+        for( const BandedRun& run : bandedRuns )
+        {
+            BenchmarkResult result = runBenchmark( run.id_, run.transform_, run.matrix_, baseFactor, options );
+            results.push_back( result );
+            printResult( run.name_, result, options.counters_ );
+        }
+        std::cout << std::endl;
+    }
+}
+
+// A system changed by a rank k term, solved again from scratch by simdTransform
+// or by updating the LU factorization of the unchanged system. The GFLOP/s
+// count the dense elimination for both.
+void benchmarkUpdate( const std::vector<size_t>& sizes, size_t rank, const BenchmarkOptions& options,
+                      std::vector<BenchmarkResult>& results )
+{
+    for( size_t width : sizes )
+    {
+        std::mt19937 generator( static_cast<unsigned>( width ) );
+        std::uniform_real_distribution<t_dataType> distribution( -1, 1 );
+        auto random = [&]() { return distribution( generator ); };
+
+        t_dataVector baseMatrix( width * width );
+        t_dataVector baseFactor( width );
+        std::generate( baseMatrix.begin(), baseMatrix.end(), random );
+        std::generate( baseFactor.begin(), baseFactor.end(), random );
+        for( size_t y = 0; y < width; ++y )
+        {
+            baseMatrix[ getIndex( y, y, width ) ] += static_cast<t_dataType>( width );
+        }
+
+        t_dataVector updateX( rank * width );
+        t_dataVector updateY( rank * width );
+        std::generate( updateX.begin(), updateX.end(), random );
+        std::generate( updateY.begin(), updateY.end(), random );
+        t_dataVector changedMatrix( baseMatrix );
+        for( size_t r = 0; r < rank; ++r )
+        {
+            for( size_t y = 0; y < width; ++y )
+            {
+                for( size_t x = 0; x < width; ++x )
+                {
+                    changedMatrix[ getIndex( x, y, width ) ] += updateX[ r * width + y ] * updateY[ r * width + x ];
+                }
+            }
+        }
+
+        t_dataVector baseLu( baseMatrix );
+        t_indexVector permutation( width );
+        luFactor( baseLu, permutation );
+
+        // The benchmark matrix is the factorization, the factor is left alone
+        auto updateTransform = [&]( t_dataVector& lu, t_dataVector& )
+        {
+            luUpdate( lu, permutation, updateX, updateY, rank );
+        };
+
+        // Both solutions against the changed system
+        t_dataVector matrix( changedMatrix );
+        t_dataVector solution( baseFactor );
+        simdTransform( matrix, solution );
+        backSubstitution( matrix, solution );
+        double transformError = getBackwardError( changedMatrix, baseFactor, solution );
+
+        t_dataVector lu( baseLu );
+        updateTransform( lu, solution );
+        solution = baseFactor;
+        luSolve( lu, permutation, solution );
+        std::cout << "Rank " << rank << " update " << width << "x" << width << " - backward error "
+                  << std::scientific << std::setprecision( 3 ) << getBackwardError( changedMatrix, baseFactor, solution )
+                  << ", simdTransform " << transformError << std::endl;
+
+        BenchmarkResult result = runBenchmark( "update/simd", &simdTransform<t_dataType>, changedMatrix, baseFactor, options );
+        results.push_back( result );
+        printResult( "Boost.SIMD from scratch", result, options.counters_ );
+        result = runBenchmark( "update/lu-update", updateTransform, baseLu, baseFactor, options );
+        results.push_back( result );
+        printResult( "LU rank " + std::to_string( rank ) + " update", result, options.counters_ );
+        std::cout << std::endl;
+    }
+}
+
+namespace
+{
+// Accuracy of one storage format on the float system, then its timings. The
+// storage error is what rounding the input alone costs, ||A - A16|| / ||A||.
+template< typename Storage >
+void benchmarkStorage( const t_dataVector& baseMatrix, const t_dataVector& baseFactor, const t_dataVector& reference,
+                       const BenchmarkOptions& options, std::vector<BenchmarkResult>& results )
+{
+    size_t width = baseFactor.size();
+    size_t stride = baseMatrix.size() / width;
+    t_halfVector baseHalf;
+    toStorage<Storage>( baseMatrix, baseHalf );
+    t_dataVector stored;
+    fromStorage<Storage>( baseHalf, stored );
+
+    double storageNorm = 0;
+    double matrixNorm = 0;
+    for( size_t y = 0; y < width; ++y )
+    {
+        double errorRow = 0;
+        double matrixRow = 0;
+        for( size_t x = 0; x < width; ++x )
+        {
+            errorRow += std::abs( static_cast<double>( baseMatrix[ getIndex( x, y, stride ) ] ) - stored[ getIndex( x, y, stride ) ] );
+            matrixRow += std::abs( baseMatrix[ getIndex( x, y, stride ) ] );
+        }
+        storageNorm = std::max( storageNorm, errorRow );
+        matrixNorm = std::max( matrixNorm, matrixRow );
+    }
+
+    t_halfVector half( baseHalf );
+    t_dataVector solution( baseFactor );
+    halfSimdTransform<Storage>( half, solution );
+    halfBackSubstitution<Storage>( half, solution );
+    double difference = 0;
+    double referenceNorm = 0;
+    for( size_t y = 0; y < width; ++y )
+    {
+        difference = std::max( difference, static_cast<double>( std::abs( solution[ y ] - reference[ y ] ) ) );
+        referenceNorm = std::max( referenceNorm, static_cast<double>( std::abs( reference[ y ] ) ) );
+    }
+    std::cout << Storage::getName() << " storage (" << Storage::getConversion() << ") " << width << "x" << width
+              << " - storage error " << std::scientific << std::setprecision( 3 ) << storageNorm / matrixNorm
+              << ", backward error " << getBackwardError( baseMatrix, baseFactor, solution )
+              << ", solution against float " << difference / referenceNorm << std::endl;
+
+    std::string name = std::string( "Boost.SIMD " ) + Storage::getName() + " storage";
+    BenchmarkResult result = runHalfBenchmark( std::string( "half/simd-" ) + Storage::getName(),
+                                               &halfSimdTransform<Storage>, baseHalf, baseFactor, options );
+    results.push_back( result );
+    printResult( name, result, options.counters_ );
+#ifdef _OPENMP
+    result = runHalfBenchmark( std::string( "half/simd-openmp-" ) + Storage::getName(),
+                               &halfSimdOpenMPTransform<Storage>, baseHalf, baseFactor, options );
+    results.push_back( result );
+    printResult( name + " OpenMP", result, options.counters_ );
+#endif // _OPENMP
+}
+} // namespace
+
+// float, fp16 and bf16 storage of the same diagonally dominant system. The
+// GB/s count each format's own element size, the GFLOP/s the same work.
+void benchmarkHalf( const std::vector<size_t>& sizes, const BenchmarkOptions& options,
+                    std::vector<BenchmarkResult>& results )
+{
+    for( size_t width : sizes )
+    {
+        std::mt19937 generator( static_cast<unsigned>( width ) );
+        std::uniform_real_distribution<t_dataType> distribution( -1, 1 );
+        size_t stride = getStride<t_dataType>( width );
+
+        t_dataVector baseMatrix( width * stride );
+        t_dataVector baseFactor( width );
+        for( size_t y = 0; y < width; ++y )
+        {
+            for( size_t x = 0; x < width; ++x )
+            {
+                baseMatrix[ getIndex( x, y, stride ) ] = distribution( generator );
+            }
+            baseMatrix[ getIndex( y, y, stride ) ] += static_cast<t_dataType>( width );
+        }
+        std::generate( baseFactor.begin(), baseFactor.end(), [&]() { return distribution( generator ); } );
+
+        t_dataVector matrix( baseMatrix );
+        t_dataVector reference( baseFactor );
+        simdTransform( matrix, reference );
+        backSubstitution( matrix, reference );
+        std::cout << "float storage " << width << "x" << width << " - backward error "
+                  << std::scientific << std::setprecision( 3 ) << getBackwardError( baseMatrix, baseFactor, reference ) << std::endl;
+
+        BenchmarkResult result = runBenchmark( "half/simd", &simdTransform<t_dataType>, baseMatrix, baseFactor, options );
+        results.push_back( result );
+        printResult( "Boost.SIMD float storage", result, options.counters_ );
+#ifdef _OPENMP
+        result = runBenchmark( "half/simd-openmp", &simdOpenMPTransform<t_dataType>, baseMatrix, baseFactor, options );
+        results.push_back( result );
+        printResult( "Boost.SIMD float storage OpenMP", result, options.counters_ );
+#endif // _OPENMP
+
+        benchmarkStorage<Fp16Storage>( baseMatrix, baseFactor, reference, options, results );
+        benchmarkStorage<Bf16Storage>( baseMatrix, baseFactor, reference, options, results );
+        std::cout << std::endl;
+    }
+}
+
+// Every client keeps a few requests in flight, so the service sees the
+// concurrency of that many callers with some pipelining each. Every solution
+// is checked against simdTransform on the same diagonally dominant system.
+int benchmarkService( const std::vector<size_t>& sizes, size_t clients, size_t requestsPerClient,
+                      size_t workers, size_t splitWidth )
+{
+    const size_t inFlight = 4;
+    std::vector<t_dataVector> baseMatrices, baseFactors, references;
+    std::mt19937 systemGenerator( 1 );
+    std::uniform_real_distribution<t_dataType> distribution( -1, 1 );
+    for( size_t width : sizes )
+    {
+        baseMatrices.emplace_back( width * width );
+        baseFactors.emplace_back( width );
+        t_dataVector& matrix = baseMatrices.back();
+        for( size_t y = 0; y < width; ++y )
+        {
+            for( size_t x = 0; x < width; ++x )
+            {
+                matrix[ getIndex( x, y, width ) ] = distribution( systemGenerator );
+            }
+            matrix[ getIndex( y, y, width ) ] += static_cast<t_dataType>( width );
+        }
+        std::generate( baseFactors.back().begin(), baseFactors.back().end(), [&]() { return distribution( systemGenerator ); } );
+
+        t_dataVector eliminated( matrix );
+        references.push_back( baseFactors.back() );
+        simdTransform( eliminated, references.back() );
+        backSubstitution( eliminated, references.back() );
+    }
+
+    SolveService service( workers, 32, splitWidth );
+    std::vector<std::vector<double>> latencies( clients );
+    std::vector<double> flops( clients, 0 );
+    std::vector<size_t> wrong( clients, 0 );
+    boost::timer::cpu_timer timer;
+    std::vector<std::thread> threads;
+    for( size_t client = 0; client < clients; ++client )
+    {
+        threads.emplace_back( [&, client]
+        {
+            struct Pending
+            {
+                std::future<t_dataVector> solution_;
+                std::chrono::steady_clock::time_point submitted_;
+                size_t system_;
+            };
+            std::mt19937 generator( static_cast<unsigned>( client ) );
+            std::uniform_int_distribution<size_t> sizeDistribution( 0, sizes.size() - 1 );
+            std::deque<Pending> pending;
+            auto complete = [&]
+            {
+                t_dataVector solution = pending.front().solution_.get();
+                latencies[ client ].push_back( std::chrono::duration<double>( std::chrono::steady_clock::now() - pending.front().submitted_ ).count() );
+                const t_dataVector& reference = references[ pending.front().system_ ];
+                double difference = solution.size() == reference.size() ? 0 : std::numeric_limits<double>::infinity();
+                double norm = 0;
+                for( size_t i = 0; i < reference.size() && i < solution.size(); ++i )
+                {
+                    // std::max drops NaN, so a value that is not finite fails outright
+                    double delta = std::abs( static_cast<double>( solution[ i ] ) - reference[ i ] );
+                    difference = std::isfinite( delta ) ? std::max( difference, delta ) : std::numeric_limits<double>::infinity();
+                    norm = std::max( norm, std::abs( static_cast<double>( reference[ i ] ) ) );
+                }
+                double tolerance = 8.0 * reference.size() * std::numeric_limits<t_dataType>::epsilon();
+                if( !( difference <= tolerance * norm ) )
+                    ++wrong[ client ];
+                pending.pop_front();
+            };
+            for( size_t i = 0; i < requestsPerClient; ++i )
+            {
+                if( pending.size() == inFlight )
+                    complete();
+                size_t index = sizeDistribution( generator );
+                flops[ client ] += getEliminationFlops( sizes[ index ] );
+                pending.push_back( { service.submit( baseMatrices[ index ], baseFactors[ index ] ), std::chrono::steady_clock::now(), index } );
+            }
+            while( !pending.empty() )
+                complete();
+        } );
+    }
+    for( std::thread& thread : threads )
+    {
+        thread.join();
+    }
+    timer.stop();
 
-    matrix.reserve( matrix.size( ) + 16 * sizeof( t_dataType ) );
+    std::vector<double> all;
+    for( const std::vector<double>& clientLatencies : latencies )
+    {
+        all.insert( all.end(), clientLatencies.begin(), clientLatencies.end() );
+    }
+    if( all.empty() )
+        return( 0 );
+    std::sort( all.begin(), all.end() );
+    double seconds = static_cast<double>(timer.elapsed().wall) / 1000000000.0;
+    double totalFlops = std::accumulate( flops.begin(), flops.end(), 0.0 );
+    SolveStats stats = service.getStats();
+
+    std::cout << "Solve service: " << clients << " clients, " << all.size() << " requests in "
+              << std::fixed << std::setprecision( 3 ) << seconds << "s - "
+              << std::setprecision( 1 ) << all.size() / seconds << " requests/s "
+              << std::setprecision( 2 ) << totalFlops / seconds / 1e9 << " GFLOP/s" << std::endl
+              << std::scientific << std::setprecision( 3 )
+              << "  queue latency mean " << stats.queueSeconds_ / stats.requests_ << "s max " << stats.maxQueueSeconds_ << "s"
+              << " - request latency median " << all[ all.size() / 2 ] << "s p95 " << all[ all.size() * 95 / 100 ] << "s" << std::endl
+              << "  " << stats.batches_ << " batches, " << stats.splits_ << " split systems" << std::endl;
+
+    size_t wrongTotal = std::accumulate( wrong.begin(), wrong.end(), size_t( 0 ) );
+    if( wrongTotal )
+        std::cout << "  " << wrongTotal << " solutions differ from simdTransform" << std::endl;
+    return( wrongTotal ? 1 : 0 );
+}
+
+// Fresh working copies for every solve, as a service does: setup is the
+// allocation and copy, solve the transform on that new buffer
+void benchmarkArena( size_t width, size_t loopCount )
+{
+    t_arenaMode initialMode = getArenaMode();
+    t_dataVector baseMatrix( width * width );
+    t_dataVector baseFactor( width );
+    setupMatrix( baseMatrix );
+    setupMatrix( baseFactor );
+
+    t_arenaMode modes[] = { t_arenaMode::aligned, t_arenaMode::pool, t_arenaMode::transparentHuge, t_arenaMode::explicitHuge };
+    for( t_arenaMode mode : modes )
+    {
+        setArenaMode( mode );
+
+        PerfCounters counters;
+        boost::timer::cpu_timer setupTimer, solveTimer;
+        setupTimer.stop();
+        solveTimer.stop();
+        for( size_t i = 0; i < loopCount; ++i )
+        {
+            setupTimer.resume();
+            t_dataVector matrix( baseMatrix );
+            t_dataVector factor( baseFactor );
+            setupTimer.stop();
+
+            counters.start();
+            solveTimer.resume();
+            simdTransform( matrix, factor );
+            solveTimer.stop();
+            counters.stop();
+        }
+
+        double setupSeconds = static_cast<double>(setupTimer.elapsed().wall) / 1000000000.0;
+        double solveSeconds = static_cast<double>(solveTimer.elapsed().wall) / 1000000000.0;
+        double dtlbMisses = counters.get( t_counter::dtlbMisses ) / loopCount;
+        std::cout << "Arena " << std::left << std::setw( 8 ) << getArenaModeName( mode ) << std::right
+                  << " " << width << "x" << width
+                  << std::scientific << std::setprecision( 3 )
+                  << " - setup " << setupSeconds / loopCount << "s solve " << solveSeconds / loopCount << "s"
+                  << " - dTLB miss ";
+        if( std::isnan( dtlbMisses ) )
+            std::cout << "n/a";
+        else
+            std::cout << dtlbMisses;
+        std::cout << std::endl;
+    }
+    std::cout << std::endl;
+
+    setArenaMode( initialMode );
+}
+
+void benchmarkPrecision( size_t width, size_t loopCount )
+{
+    t_dataVector floatMatrix( width * width );
+    t_dataVector floatFactor( width );
+    setupMatrix( floatMatrix );
+    setupMatrix( floatFactor );
+    t_vector<double> baseMatrix( floatMatrix.begin(), floatMatrix.end() );
+    t_vector<double> baseFactor( floatFactor.begin(), floatFactor.end() );
+
+    auto residual = [&]( const t_vector<double>& solution )
+    {
+        double maxResidual = 0;
+        for( size_t y = 0; y < width; ++y )
+        {
+            double sum = 0;
+            for( size_t x = 0; x < width; ++x )
+            {
+                sum += baseMatrix[ getIndex( x, y, width ) ] * solution[ x ];
+            }
+            maxResidual = std::max( maxResidual, std::abs( sum - baseFactor[ y ] ) );
+        }
+        return( maxResidual );
+    };
+
+    boost::timer::cpu_timer timer;
+    auto report = [&]( const std::string& name, const t_vector<double>& solution )
+    {
+        double seconds = static_cast<double>(timer.elapsed().wall) / 1000000000.0;
+        std::cout << name << " time: "
+                  << timer.format( boost::timer::default_places, "%ws wall, %us user + %ss system = %ts CPU (%p%)" )
+                  << " - " << std::fixed << std::setprecision(6) << loopCount / seconds << " solve/s"
+                  << " - residual " << std::scientific << std::setprecision(3) << residual( solution )
+                  << std::endl << std::endl;
+    };
+
+    t_vector<double> matrix, solution;
+    t_indexVector permutation( width );
+    timer.start();
+    for( size_t i = 0; i < loopCount; ++i )
+    {
+        matrix = baseMatrix;
+        solution = baseFactor;
+        luFactor( matrix, permutation );
+        luSolve( matrix, permutation, solution );
+    }
+    timer.stop();
+    report( "Double LU", solution );
+
+    size_t iterations = 0;
+    timer.start();
+    for( size_t i = 0; i < loopCount; ++i )
+    {
+        iterations = mixedPrecisionSolve( baseMatrix, baseFactor, solution );
+    }
+    timer.stop();
+    report( "Mixed precision (" + std::to_string( iterations ) + " solves)", solution );
 }
 
 void printMatrix( const std::string& name, const t_dataVector& matrix, size_t width, size_t height )
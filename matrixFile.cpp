@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+
+#if defined( __unix__ )
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <boost/simd/pack.hpp>
+#include <boost/simd/function/fma.hpp>
+#include <boost/simd/function/load.hpp>
+#include <boost/simd/function/store.hpp>
+
+#include "matrixFile.h"
+
+namespace bs = boost::simd;
+
+namespace
+{
+// line -= scale * base from column x on, rows of a file need not be pack aligned
+void eliminateRow( t_dataType* line, const t_dataType* base, size_t x, size_t width, t_dataType scale )
+{
+	using t_pack = bs::pack<t_dataType>;
+
+    t_pack packScale( -scale );
+    for( ; x + t_pack::static_size <= width; x += t_pack::static_size )
+    {
+        bs::store( bs::fma( packScale, bs::load<t_pack>( base + x ), bs::load<t_pack>( line + x ) ), line + x );
+    }
+    for( ; x < width; ++x )
+    {
+        line[ x ] -= scale * base[ x ];
+    }
+}
+} // namespace
+
+#if defined( __unix__ )
+MappedMatrix::MappedMatrix( const std::string& path, size_t width, bool writable ) :
+    data_( nullptr ), bytes_( 0 ), width_( width ), stride_( 0 )
+{
+    int file = open( path.c_str(), writable ? O_RDWR : O_RDONLY );
+    if( file < 0 )
+        throw std::runtime_error( "Cannot open " + path );
+
+    struct stat status;
+    if( fstat( file, &status ) != 0 || width == 0 ||
+        static_cast<size_t>( status.st_size ) % (width * sizeof( t_dataType )) != 0 ||
+        static_cast<size_t>( status.st_size ) / (width * sizeof( t_dataType )) < width )
+    {
+        close( file );
+        throw std::runtime_error( path + " does not hold " + std::to_string( width ) + " whole rows" );
+    }
+    bytes_ = static_cast<size_t>( status.st_size );
+    stride_ = bytes_ / (width * sizeof( t_dataType ));
+
+    void* mapping = mmap( nullptr, bytes_, PROT_READ | PROT_WRITE, writable ? MAP_SHARED : MAP_PRIVATE, file, 0 );
+    close( file );
+    if( mapping == MAP_FAILED )
+        throw std::runtime_error( "Cannot map " + path );
+    data_ = static_cast<t_dataType*>( mapping );
+}
+
+MappedMatrix::~MappedMatrix()
+{
+    munmap( data_, bytes_ );
+}
+
+void MappedMatrix::advise( size_t firstRow, size_t rows, int advice )
+{
+    if( firstRow >= width_ || rows == 0 )
+        return;
+
+    uintptr_t pageSize = static_cast<uintptr_t>( sysconf( _SC_PAGESIZE ) );
+    uintptr_t begin = reinterpret_cast<uintptr_t>( row( firstRow ) ) & ~(pageSize - 1);
+    uintptr_t end = reinterpret_cast<uintptr_t>( row( std::min( width_, firstRow + rows ) ) );
+    if( advice < 0 )
+        msync( reinterpret_cast<void*>( begin ), end - begin, MS_ASYNC );
+    else
+        madvise( reinterpret_cast<void*>( begin ), end - begin, advice );
+}
+
+void MappedMatrix::willNeed( size_t firstRow, size_t rows ) { advise( firstRow, rows, MADV_WILLNEED ); }
+void MappedMatrix::dontNeed( size_t firstRow, size_t rows ) { advise( firstRow, rows, MADV_DONTNEED ); }
+void MappedMatrix::sync( size_t firstRow, size_t rows ) { advise( firstRow, rows, -1 ); }
+#else
+MappedMatrix::MappedMatrix( const std::string& path, size_t width, bool ) :
+    data_( nullptr ), bytes_( 0 ), width_( width ), stride_( 0 )
+{
+    throw std::runtime_error( "Cannot map " + path + ", memory mapped matrices need a POSIX host" );
+}
+
+MappedMatrix::~MappedMatrix() {}
+void MappedMatrix::advise( size_t, size_t, int ) {}
+void MappedMatrix::willNeed( size_t, size_t ) {}
+void MappedMatrix::dontNeed( size_t, size_t ) {}
+void MappedMatrix::sync( size_t, size_t ) {}
+#endif
+
+void writeRandomSystem( const std::string& matrixPath, const std::string& factorPath, size_t width, unsigned seed )
+{
+    std::mt19937 generator( seed );
+    std::uniform_real_distribution<t_dataType> distribution( -1, 1 );
+
+    std::ofstream file( matrixPath, std::ios::binary | std::ios::trunc );
+    t_dataVector row( getStride<t_dataType>( width ) );
+    for( size_t y = 0; y < width && file; ++y )
+    {
+        std::generate( row.begin(), row.begin() + width, [&]() { return distribution( generator ); } );
+        row[ y ] += static_cast<t_dataType>( width );
+        file.write( reinterpret_cast<const char*>( row.data() ), row.size() * sizeof( t_dataType ) );
+    }
+    if( !file )
+        throw std::runtime_error( "Cannot write " + matrixPath );
+
+    t_dataVector factor( width );
+    std::generate( factor.begin(), factor.end(), [&]() { return distribution( generator ); } );
+    writeVectorFile( factorPath, factor );
+}
+
+t_dataVector readVectorFile( const std::string& path )
+{
+    std::ifstream file( path, std::ios::binary | std::ios::ate );
+    if( !file )
+        throw std::runtime_error( "Cannot open " + path );
+
+    t_dataVector data( static_cast<size_t>( file.tellg() ) / sizeof( t_dataType ) );
+    file.seekg( 0 );
+    file.read( reinterpret_cast<char*>( data.data() ), data.size() * sizeof( t_dataType ) );
+    return( data );
+}
+
+void writeVectorFile( const std::string& path, const t_dataVector& data )
+{
+    std::ofstream file( path, std::ios::binary | std::ios::trunc );
+    if( !file.write( reinterpret_cast<const char*>( data.data() ), data.size() * sizeof( t_dataType ) ) )
+        throw std::runtime_error( "Cannot write " + path );
+}
+
+void outOfCoreTransform( MappedMatrix& matrix, t_dataVector& factor, size_t panelRows )
+{
+    size_t width = matrix.width();
+    panelRows = std::max<size_t>( 1, std::min( panelRows, width ) );
+
+    for( size_t panel = 0; panel < width; panel += panelRows )
+    {
+        size_t panelEnd = std::min( width, panel + panelRows );
+        matrix.willNeed( panel, panelEnd - panel );
+        matrix.willNeed( 0, std::min( panel, panelRows ) );
+
+        // Updates from the finished rows above, one panel of them at a time while
+        // the next one is read ahead. Each row takes its pivots in order, as in
+        // the in memory elimination.
+        for( size_t source = 0; source < panel; source += panelRows )
+        {
+            size_t sourceEnd = std::min( panel, source + panelRows );
+            matrix.willNeed( sourceEnd, std::min( panel, sourceEnd + panelRows ) - sourceEnd );
+
+            for( size_t line = source; line < sourceEnd; ++line )
+            {
+                const t_dataType* pBase = matrix.row( line );
+                for( size_t y = panel; y < panelEnd; ++y )
+                {
+                    t_dataType* pLine = matrix.row( y );
+                    t_dataType scale = pLine[ line ] / pBase[ line ];
+                    factor[ y ] -= scale * factor[ line ];
+                    eliminateRow( pLine, pBase, line, width, scale );
+                }
+            }
+            matrix.dontNeed( source, sourceEnd - source );
+        }
+
+        // Elimination inside the panel
+        for( size_t line = panel; line + 1 < panelEnd; ++line )
+        {
+            const t_dataType* pBase = matrix.row( line );
+            for( size_t y = line + 1; y < panelEnd; ++y )
+            {
+                t_dataType* pLine = matrix.row( y );
+                t_dataType scale = pLine[ line ] / pBase[ line ];
+                factor[ y ] -= scale * factor[ line ];
+                eliminateRow( pLine, pBase, line, width, scale );
+            }
+        }
+
+        matrix.sync( panel, panelEnd - panel );
+        matrix.dontNeed( panel, panelEnd - panel );
+    }
+}
+
+void outOfCoreBackSubstitution( MappedMatrix& matrix, t_dataVector& factor )
+{
+    size_t width = matrix.width();
+    size_t readAhead = std::max<size_t>( 1, (1 << 20) / (matrix.stride() * sizeof( t_dataType )) );
+    for( size_t y = width; y-- > 0; )
+    {
+        if( (width - 1 - y) % readAhead == 0 )
+            matrix.willNeed( y >= readAhead ? y - readAhead : 0, std::min( y, readAhead ) );
+
+        const t_dataType* pLine = matrix.row( y );
+        t_dataType sum = factor[ y ];
+        for( size_t x = y + 1; x < width; ++x )
+        {
+            sum -= pLine[ x ] * factor[ x ];
+        }
+        factor[ y ] = sum / pLine[ y ];
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#ifndef __MATRIX_FILE__
+#define __MATRIX_FILE__
+
+#include <string>
+
+#include "boostSimd.h"
+
+// Raw matrix file: width rows of stride t_dataType values, row major, native
+// endianness, no header. The stride is the file size over the row count, so
+// getStride() padded files map straight into the aligned kernel layout. The
+// mapping is page aligned, the kernels read it in place without a parse step.
+class MappedMatrix
+{
+public:
+    // writable maps the file shared, kernel writes go back to the file; otherwise
+    // writes stay private to the process and the file is untouched
+    MappedMatrix( const std::string& path, size_t width, bool writable );
+    ~MappedMatrix();
+
+    MappedMatrix( const MappedMatrix& ) = delete;
+    MappedMatrix& operator=( const MappedMatrix& ) = delete;
+
+    t_dataType* data() { return( data_ ); }
+    t_dataType* row( size_t y ) { return( data_ + getIndex( 0, y, stride_ ) ); }
+    size_t width() const { return( width_ ); }
+    size_t stride() const { return( stride_ ); }
+
+    // Page cache hints over whole rows: start reading ahead, drop from the
+    // mapping (dirty pages stay in the page cache), schedule the write back
+    void willNeed( size_t firstRow, size_t rows );
+    void dontNeed( size_t firstRow, size_t rows );
+    void sync( size_t firstRow, size_t rows );
+
+private:
+    void advise( size_t firstRow, size_t rows, int advice );
+
+    t_dataType* data_;
+    size_t bytes_;
+    size_t width_;
+    size_t stride_;
+};
+
+// Random diagonally dominant system written row by row, so it may exceed memory;
+// rows are padded to getStride()
+void writeRandomSystem( const std::string& matrixPath, const std::string& factorPath, size_t width, unsigned seed );
+
+t_dataVector readVectorFile( const std::string& path );
+void writeVectorFile( const std::string& path, const t_dataVector& data );
+
+// Elimination for matrices larger than memory, in place in a writable mapping.
+// Panels of panelRows rows are finished one after the other: each first takes
+// the updates of every finished pivot row, streamed from the file with the next
+// panel read ahead, then eliminates inside itself. Same result as the in memory
+// transforms, the factor stays in memory.
+void outOfCoreTransform( MappedMatrix& matrix, t_dataVector& factor, size_t panelRows );
+
+// Back substitution streaming the rows from the last one up, the solution
+// replaces the factor
+void outOfCoreBackSubstitution( MappedMatrix& matrix, t_dataVector& factor );
+
+#endif // __MATRIX_FILE__
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <boost/simd/pack.hpp>
+#include <boost/simd/function/fma.hpp>
+
+#include "numaSimd.h"
+
+namespace bs = boost::simd;
+
+namespace
+{
+// Linux cpulist format: "0-3,8,10-11"
+std::vector<int> parseCpuList( const std::string& list )
+{
+    std::vector<int> cpus;
+    std::istringstream stream( list );
+    std::string range;
+    while( std::getline( stream, range, ',' ) )
+    {
+        size_t dash = range.find( '-' );
+        int first = std::stoi( range.substr( 0, dash ) );
+        int last = (dash == std::string::npos) ? first : std::stoi( range.substr( dash + 1 ) );
+        for( int cpu = first; cpu <= last; ++cpu )
+        {
+            cpus.push_back( cpu );
+        }
+    }
+    return( cpus );
+}
+
+std::vector<int> getAllowedCpus()
+{
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    if( sched_getaffinity( 0, sizeof( set ), &set ) == 0 )
+    {
+        for( int cpu = 0; cpu < CPU_SETSIZE; ++cpu )
+        {
+            if( CPU_ISSET( cpu, &set ) )
+                cpus.push_back( cpu );
+        }
+    }
+#endif
+    if( cpus.empty() )
+        cpus.push_back( 0 );
+    return( cpus );
+}
+
+#ifdef __linux__
+int getCurrentNode()
+{
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if( syscall( SYS_getcpu, &cpu, &node, nullptr ) != 0 )
+        return( -1 );
+    return( static_cast<int>( node ) );
+}
+
+// move_pages(2) without libnuma, MPOL_MF_MOVE moves pages only this process uses
+void movePages( std::vector<void*>& pages, int node )
+{
+    const int movePagesFlag = 1 << 1;
+    std::vector<int> nodes( pages.size(), node );
+    std::vector<int> status( pages.size() );
+    syscall( SYS_move_pages, 0, pages.size(), pages.data(), nodes.data(), status.data(), movePagesFlag );
+}
+#endif
+} // namespace
+
+std::vector<std::vector<int>> getNumaNodes()
+{
+    std::vector<int> allowed = getAllowedCpus();
+    std::vector<std::vector<int>> nodes;
+    for( int node = 0; ; ++node )
+    {
+        std::ifstream file( "/sys/devices/system/node/node" + std::to_string( node ) + "/cpulist" );
+        std::string list;
+        if( !file || !std::getline( file, list ) )
+            break;
+
+        std::vector<int> cpus;
+        for( int cpu : parseCpuList( list ) )
+        {
+            if( std::find( allowed.begin(), allowed.end(), cpu ) != allowed.end() )
+                cpus.push_back( cpu );
+        }
+        if( !cpus.empty() )
+            nodes.push_back( cpus );
+    }
+
+    if( nodes.empty() )
+        nodes.push_back( allowed );
+    return( nodes );
+}
+
+void pinThreads( const std::vector<int>& cpus )
+{
+#if defined( __linux__ ) && defined( _OPENMP )
+    #pragma omp parallel
+    {
+        cpu_set_t set;
+        CPU_ZERO( &set );
+        CPU_SET( cpus[ static_cast<size_t>( omp_get_thread_num() ) % cpus.size() ], &set );
+        sched_setaffinity( 0, sizeof( set ), &set );
+    }
+#else
+    (void)cpus;
+#endif
+}
+
+size_t getNumaRowBlock( size_t stride, size_t elementSize )
+{
+    size_t pageSize = 4096;
+#ifdef __linux__
+    pageSize = static_cast<size_t>( sysconf( _SC_PAGESIZE ) );
+#endif
+    size_t rowSize = stride * elementSize;
+    return( std::max<size_t>( 1, (pageSize + rowSize - 1) / rowSize ) );
+}
+
+#ifdef _OPENMP
+template< typename T >
+void distributeRows( t_vector<T>& matrix, size_t width )
+{
+#ifdef __linux__
+    size_t stride = matrix.size() / width;
+    size_t rowBlock = getNumaRowBlock( stride, sizeof( T ) );
+    size_t blocks = (width + rowBlock - 1) / rowBlock;
+    uintptr_t pageSize = static_cast<uintptr_t>( sysconf( _SC_PAGESIZE ) );
+
+    #pragma omp parallel
+    {
+        size_t thread = static_cast<size_t>( omp_get_thread_num() );
+        size_t threads = static_cast<size_t>( omp_get_num_threads() );
+        int node = getCurrentNode();
+
+        std::vector<void*> pages;
+        for( size_t block = thread; block < blocks && node >= 0; block += threads )
+        {
+            uintptr_t begin = reinterpret_cast<uintptr_t>( &matrix[ getIndex( 0, block * rowBlock, stride ) ] );
+            uintptr_t end = reinterpret_cast<uintptr_t>( matrix.data() + std::min( matrix.size(), getIndex( 0, (block + 1) * rowBlock, stride ) ) );
+            for( uintptr_t page = begin & ~(pageSize - 1); page < end; page += pageSize )
+            {
+                pages.push_back( reinterpret_cast<void*>( page ) );
+            }
+        }
+        if( !pages.empty() )
+            movePages( pages, node );
+    }
+#else
+    (void)matrix;
+    (void)width;
+#endif
+}
+
+template< typename T >
+void numaSimdOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor )
+{
+	using t_pack = bs::pack<T>;
+
+	size_t width = factor.size();
+	size_t stride = matrix.size() / width;
+    if( stride % t_pack::static_size )
+    {
+        unalignedSimdOpenMPTransform( matrix, factor );
+        return;
+    }
+    size_t rowBlock = getNumaRowBlock( stride, sizeof( T ) );
+    size_t blocks = (width + rowBlock - 1) / rowBlock;
+    t_pack* packMatrix = reinterpret_cast<t_pack*>( matrix.data() );
+
+    #pragma omp parallel
+    {
+        size_t thread = static_cast<size_t>( omp_get_thread_num() );
+        size_t threads = static_cast<size_t>( omp_get_num_threads() );
+        for( size_t line = 0; line < width - 1; ++line )
+        {
+            size_t normLine = line & ~(static_cast<size_t>(t_pack::static_size - 1));
+            const t_pack* packBase = &( packMatrix[ getIndex( normLine, line, stride ) / t_pack::static_size ] );
+
+            // First owned block holding a row below the pivot
+            size_t block = (line + 1) / rowBlock;
+            block += (thread + threads - block % threads) % threads;
+            for( ; block < blocks; block += threads )
+            {
+                size_t end = std::min( width, (block + 1) * rowBlock );
+                for( size_t y = std::max( line + 1, block * rowBlock ); y < end; ++y )
+                {
+                    T scale = matrix[ getIndex( line, y, stride ) ] / matrix[ getIndex( line, line, stride ) ];
+                    factor[ y ] = bs::fma( -scale, factor[ line ], factor[ y ] );
+
+                    t_pack* packLine = &( packMatrix[ getIndex( normLine, y, stride ) / t_pack::static_size ] );
+                    t_pack packScale( -scale );
+                    for( size_t x = normLine, i = 0; x < width; x += t_pack::static_size, ++i )
+                    {
+                        packLine[ i ] = bs::fma( packScale, packBase[ i ], packLine[ i ] );
+                    }
+                }
+            }
+
+            // Row line + 1 is the next pivot row
+            #pragma omp barrier
+        }
+    }
+}
+
+#define INSTANTIATE_NUMA_TRANSFORMS( T ) \
+template void distributeRows( t_vector<T>& matrix, size_t width ); \
+template void numaSimdOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor );
+
+INSTANTIATE_NUMA_TRANSFORMS( float )
+INSTANTIATE_NUMA_TRANSFORMS( double )
+#endif // _OPENMP
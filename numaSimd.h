@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#ifndef __NUMA_SIMD__
+#define __NUMA_SIMD__
+
+#include <vector>
+
+#include "boostSimd.h"
+
+// CPUs of each NUMA node, read from /sys/devices/system/node. A host without
+// that information is one node holding every CPU this process may run on.
+std::vector<std::vector<int>> getNumaNodes();
+
+// Pins OpenMP thread i to cpus[ i % cpus.size() ]. Does nothing without Linux.
+void pinThreads( const std::vector<int>& cpus );
+
+// Rows handed out together, at least one page each, so every row block can
+// live on the node of its thread
+size_t getNumaRowBlock( size_t stride, size_t elementSize );
+
+#ifdef _OPENMP
+// Row block b belongs to OpenMP thread b % threads, for the whole elimination.
+// distributeRows moves the pages of each block to the node its owner runs on
+// (threads should be pinned first) and numaSimdOpenMPTransform updates every
+// row on that same thread, so row traffic stays on the local node.
+template< typename T > void distributeRows( t_vector<T>& matrix, size_t width );
+template< typename T > void numaSimdOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor );
+#endif // _OPENMP
+
+#endif // __NUMA_SIMD__
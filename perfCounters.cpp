@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "perfCounters.h"
+
+namespace
+{
+#ifdef __linux__
+int openCounter( uint32_t type, uint64_t config )
+{
+    perf_event_attr attr;
+    std::memset( &attr, 0, sizeof( attr ) );
+    attr.size = sizeof( attr );
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return( static_cast<int>( syscall( __NR_perf_event_open, &attr, 0, -1, -1, 0 ) ) );
+}
+
+uint64_t getCacheConfig( uint64_t cache )
+{
+    return( cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) );
+}
+#endif
+} // namespace
+
+PerfCounters::PerfCounters()
+{
+    for( size_t i = 0; i < count_; ++i )
+    {
+        fds_[ i ] = -1;
+        values_[ i ] = 0;
+    }
+
+#ifdef __linux__
+    fds_[ static_cast<size_t>( t_counter::cycles ) ] = openCounter( PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES );
+    fds_[ static_cast<size_t>( t_counter::instructions ) ] = openCounter( PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS );
+    fds_[ static_cast<size_t>( t_counter::l1Misses ) ] = openCounter( PERF_TYPE_HW_CACHE, getCacheConfig( PERF_COUNT_HW_CACHE_L1D ) );
+    fds_[ static_cast<size_t>( t_counter::llcMisses ) ] = openCounter( PERF_TYPE_HW_CACHE, getCacheConfig( PERF_COUNT_HW_CACHE_LL ) );
+    fds_[ static_cast<size_t>( t_counter::dtlbMisses ) ] = openCounter( PERF_TYPE_HW_CACHE, getCacheConfig( PERF_COUNT_HW_CACHE_DTLB ) );
+
+    // Intel FP_ARITH_INST_RETIRED (event 0xc7), all packed umasks: 128, 256
+    // and 512 bit, single and double. Instructions, not flops.
+    fds_[ static_cast<size_t>( t_counter::fpVector ) ] = openCounter( PERF_TYPE_RAW, 0xfcc7 );
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+    for( int fd : fds_ )
+    {
+        if( fd >= 0 )
+            close( fd );
+    }
+#endif
+}
+
+bool PerfCounters::available() const
+{
+    for( int fd : fds_ )
+    {
+        if( fd >= 0 )
+            return( true );
+    }
+    return( false );
+}
+
+void PerfCounters::start()
+{
+#ifdef __linux__
+    for( int fd : fds_ )
+    {
+        if( fd >= 0 )
+        {
+            ioctl( fd, PERF_EVENT_IOC_RESET, 0 );
+            ioctl( fd, PERF_EVENT_IOC_ENABLE, 0 );
+        }
+    }
+#endif
+}
+
+void PerfCounters::stop()
+{
+#ifdef __linux__
+    for( size_t i = 0; i < count_; ++i )
+    {
+        if( fds_[ i ] >= 0 )
+            ioctl( fds_[ i ], PERF_EVENT_IOC_DISABLE, 0 );
+    }
+
+    for( size_t i = 0; i < count_; ++i )
+    {
+        // value, time enabled, time running
+        uint64_t data[ 3 ];
+        if( fds_[ i ] >= 0 && read( fds_[ i ], data, sizeof( data ) ) == sizeof( data ) && data[ 2 ] )
+        {
+            values_[ i ] += static_cast<double>( data[ 0 ] ) * data[ 1 ] / data[ 2 ];
+        }
+    }
+#endif
+}
+
+double PerfCounters::get( t_counter counter ) const
+{
+    size_t index = static_cast<size_t>( counter );
+    return( fds_[ index ] >= 0 ? values_[ index ] : std::numeric_limits<double>::quiet_NaN() );
+}
+
+const char* PerfCounters::getName( t_counter counter )
+{
+    switch( counter )
+    {
+    case t_counter::cycles:         return( "cycles" );
+    case t_counter::instructions:   return( "instructions" );
+    case t_counter::l1Misses:       return( "l1d_misses" );
+    case t_counter::llcMisses:      return( "llc_misses" );
+    case t_counter::dtlbMisses:     return( "dtlb_misses" );
+    case t_counter::fpVector:       return( "fp_vector" );
+    default:                        return( "" );
+    }
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#ifndef __PERF_COUNTERS__
+#define __PERF_COUNTERS__
+
+#include <cstddef>
+
+// Hardware events recorded around each timed run
+enum class t_counter { cycles, instructions, l1Misses, llcMisses, dtlbMisses, fpVector, count };
+
+// perf_event_open counters of the calling thread, user space only. OpenMP
+// worker threads are not counted. Events the kernel or the CPU refuses (no
+// Linux, perf_event_paranoid, no FP_ARITH_INST_RETIRED outside Intel) read as
+// NaN, the others keep working.
+class PerfCounters
+{
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters( const PerfCounters& ) = delete;
+    PerfCounters& operator=( const PerfCounters& ) = delete;
+
+    bool available() const;
+
+    void start();
+    void stop();
+
+    // Sum over all start/stop pairs, scaled for multiplexing
+    double get( t_counter counter ) const;
+
+    static const char* getName( t_counter counter );
+
+private:
+    static const size_t count_ = static_cast<size_t>( t_counter::count );
+
+    int fds_[ count_ ];
+    double values_[ count_ ];
+};
+
+#endif // __PERF_COUNTERS__
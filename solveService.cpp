@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+
+#include <boost/simd/pack.hpp>
+#include <boost/simd/function/fma.hpp>
+#include <boost/simd/function/load.hpp>
+#include <boost/simd/function/store.hpp>
+
+#include "solveService.h"
+
+namespace bs = boost::simd;
+
+struct SolveService::Request
+{
+    t_dataVector matrix_;
+    t_dataVector factor_;
+    std::promise<t_dataVector> solution_;
+    std::chrono::steady_clock::time_point submitted_;
+};
+
+// One system eliminated by every worker that joins. ticket_ holds the pivot line
+// in the high half and the next unclaimed row in the low half, so a claim always
+// belongs to the line it was made on; the owner moves to the next line once
+// doneRows_ covers every row under the pivot. It starts at line 0 with no rows
+// left, so helpers that get there before the owner wait for the first line.
+struct SolveService::SplitJob
+{
+    t_dataType* matrix_;
+    t_dataType* factor_;
+    size_t width_;
+    size_t stride_;
+    std::atomic<uint64_t> ticket_;
+    std::atomic<size_t> doneRows_;
+};
+
+namespace
+{
+const size_t splitRows_ = 16;
+
+enum class t_claim { finished, idle, claimed };
+
+void eliminateRows( t_dataType* matrix, t_dataType* factor, size_t width, size_t stride, size_t line, size_t first, size_t last )
+{
+	using t_pack = bs::pack<t_dataType>;
+
+    const t_dataType* pBase = matrix + getIndex( 0, line, stride );
+    for( size_t y = first; y < last; ++y )
+    {
+        t_dataType* pLine = matrix + getIndex( 0, y, stride );
+        t_dataType scale = pLine[ line ] / pBase[ line ];
+        factor[ y ] = bs::fma( -scale, factor[ line ], factor[ y ] );
+
+        t_pack packScale( -scale );
+        size_t x = line;
+        for( ; x + t_pack::static_size <= width; x += t_pack::static_size )
+        {
+            bs::store( bs::fma( packScale, bs::load<t_pack>( pBase + x ), bs::load<t_pack>( pLine + x ) ), pLine + x );
+        }
+        for( ; x < width; ++x )
+        {
+            pLine[ x ] = bs::fma( -scale, pBase[ x ], pLine[ x ] );
+        }
+    }
+}
+
+template< typename Job >
+t_claim claimRows( Job& job )
+{
+    uint64_t ticket = job.ticket_.load( std::memory_order_acquire );
+    if( (ticket >> 32) + 1 >= job.width_ )
+        return( t_claim::finished );
+    if( (ticket & 0xffffffff) >= job.width_ )
+        return( t_claim::idle );
+
+    ticket = job.ticket_.fetch_add( splitRows_, std::memory_order_acq_rel );
+    size_t line = static_cast<size_t>( ticket >> 32 );
+    size_t first = static_cast<size_t>( ticket & 0xffffffff );
+    if( line + 1 >= job.width_ )
+        return( t_claim::finished );
+    if( first >= job.width_ )
+        return( t_claim::idle );
+
+    size_t last = std::min( first + splitRows_, job.width_ );
+    eliminateRows( job.matrix_, job.factor_, job.width_, job.stride_, line, first, last );
+    job.doneRows_.fetch_add( last - first, std::memory_order_release );
+    return( t_claim::claimed );
+}
+
+template< typename Job >
+void helpJob( Job& job )
+{
+    for( t_claim claim = claimRows( job ); claim != t_claim::finished; claim = claimRows( job ) )
+    {
+        if( claim == t_claim::idle )
+            std::this_thread::yield();
+    }
+}
+} // namespace
+
+SolveService::SolveService( size_t threads, size_t batchWidth, size_t splitWidth )
+    : batchWidth_( batchWidth )
+    , splitWidth_( splitWidth )
+    , maxBatch_( 8 * getBatchLanes<t_dataType>() )
+    , splitDelay_( 0 )
+    , stop_( false )
+    , stats_()
+{
+    for( size_t i = 0; i < std::max<size_t>( threads, 1 ); ++i )
+    {
+        workers_.emplace_back( &SolveService::work, this );
+    }
+}
+
+SolveService::~SolveService()
+{
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for( std::thread& worker : workers_ )
+    {
+        worker.join();
+    }
+}
+
+std::future<t_dataVector> SolveService::submit( t_dataVector matrix, t_dataVector factor )
+{
+    size_t width = factor.size();
+    if( width == 0 || matrix.size() % width || matrix.size() / width < width )
+        throw std::invalid_argument( "SolveService: matrix does not match the factor width" );
+
+    std::unique_ptr<Request> request( new Request );
+    request->matrix_.swap( matrix );
+    request->factor_.swap( factor );
+    request->submitted_ = std::chrono::steady_clock::now();
+    std::future<t_dataVector> solution = request->solution_.get_future();
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        queue_.push_back( std::move( request ) );
+    }
+    wake_.notify_one();
+    return( solution );
+}
+
+void SolveService::setSplitDelay( std::chrono::milliseconds delay )
+{
+    splitDelay_ = delay;
+}
+
+SolveStats SolveService::getStats() const
+{
+    std::lock_guard<std::mutex> lock( mutex_ );
+    return( stats_ );
+}
+
+// Split jobs first, they hold a system another worker is already on; then the
+// oldest request, with the queued ones of the same small width behind it
+void SolveService::work()
+{
+    std::vector<std::unique_ptr<Request>> requests;
+    for( ;; )
+    {
+        std::shared_ptr<SplitJob> job;
+        {
+            std::unique_lock<std::mutex> lock( mutex_ );
+            wake_.wait( lock, [this]{ return( stop_ || !helpers_.empty() || !queue_.empty() ); } );
+            if( !helpers_.empty() )
+            {
+                job = helpers_.front();
+                helpers_.pop_front();
+            }
+            else if( queue_.empty() )
+            {
+                return;
+            }
+            else
+            {
+                size_t width = queue_.front()->factor_.size();
+                requests.push_back( std::move( queue_.front() ) );
+                queue_.pop_front();
+                for( auto it = queue_.begin(); width <= batchWidth_ && it != queue_.end() && requests.size() < maxBatch_; )
+                {
+                    if( (*it)->factor_.size() == width )
+                    {
+                        requests.push_back( std::move( *it ) );
+                        it = queue_.erase( it );
+                    }
+                    else
+                    {
+                        ++it;
+                    }
+                }
+
+                auto now = std::chrono::steady_clock::now();
+                for( const auto& request : requests )
+                {
+                    double seconds = std::chrono::duration<double>( now - request->submitted_ ).count();
+                    stats_.queueSeconds_ += seconds;
+                    stats_.maxQueueSeconds_ = std::max( stats_.maxQueueSeconds_, seconds );
+                }
+            }
+        }
+
+        if( job )
+        {
+            helpJob( *job );
+            continue;
+        }
+
+        try
+        {
+            solve( requests );
+        }
+        catch( ... )
+        {
+            for( auto& request : requests )
+            {
+                request->solution_.set_exception( std::current_exception() );
+            }
+        }
+        requests.clear();
+    }
+}
+
+void SolveService::solve( std::vector<std::unique_ptr<Request>>& requests )
+{
+    Request& request = *requests.front();
+    size_t width = request.factor_.size();
+    if( requests.size() > 1 )
+    {
+        solveBatch( requests );
+        return;
+    }
+    if( width >= splitWidth_ && workers_.size() > 1 )
+        solveSplit( request );
+    else
+        simdTransform( request.matrix_, request.factor_ );
+    backSubstitution( request.matrix_, request.factor_ );
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        ++stats_.requests_;
+    }
+    request.solution_.set_value( std::move( request.factor_ ) );
+}
+
+void SolveService::solveBatch( std::vector<std::unique_ptr<Request>>& requests )
+{
+    size_t width = requests.front()->factor_.size();
+    size_t size = width * width;
+    size_t count = requests.size();
+
+    t_dataVector matrices( count * size );
+    t_dataVector factors( count * width );
+    for( size_t system = 0; system < count; ++system )
+    {
+        const t_dataVector& matrix = requests[ system ]->matrix_;
+        size_t stride = matrix.size() / width;
+        for( size_t y = 0; y < width; ++y )
+        {
+            std::copy_n( &matrix[ getIndex( 0, y, stride ) ], width, &matrices[ system * size + getIndex( 0, y, width ) ] );
+        }
+        std::copy_n( requests[ system ]->factor_.begin(), width, &factors[ system * width ] );
+    }
+
+    t_dataVector batchMatrices, batchFactors;
+    interleaveBatch( matrices, batchMatrices, size );
+    interleaveBatch( factors, batchFactors, width );
+    batchedSimdTransform( batchMatrices, batchFactors, width );
+    deinterleaveBatch( batchMatrices, matrices, size );
+    deinterleaveBatch( batchFactors, factors, width );
+
+    std::vector<t_dataVector> solutions( count );
+    t_dataVector matrix( size );
+    for( size_t system = 0; system < count; ++system )
+    {
+        solutions[ system ].assign( factors.begin() + system * width, factors.begin() + (system + 1) * width );
+        std::copy_n( matrices.begin() + system * size, size, matrix.begin() );
+        backSubstitution( matrix, solutions[ system ] );
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        stats_.requests_ += count;
+        ++stats_.batches_;
+    }
+    for( size_t system = 0; system < count; ++system )
+    {
+        requests[ system ]->solution_.set_value( std::move( solutions[ system ] ) );
+    }
+}
+
+// The owner publishes one pivot line at a time and works on it with whoever
+// joined; a worker joining late starts at the current line, one that never
+// gets there finds the job finished and leaves
+void SolveService::solveSplit( Request& request )
+{
+    size_t width = request.factor_.size();
+    std::shared_ptr<SplitJob> job = std::make_shared<SplitJob>();
+    job->matrix_ = request.matrix_.data();
+    job->factor_ = request.factor_.data();
+    job->width_ = width;
+    job->stride_ = request.matrix_.size() / width;
+    job->ticket_.store( width, std::memory_order_relaxed );
+    job->doneRows_.store( 0, std::memory_order_relaxed );
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        for( size_t i = 1; i < workers_.size(); ++i )
+        {
+            helpers_.push_back( job );
+        }
+        ++stats_.splits_;
+    }
+    wake_.notify_all();
+    if( splitDelay_.count() )
+        std::this_thread::sleep_for( splitDelay_ );
+
+    for( size_t line = 0; line < width - 1; ++line )
+    {
+        job->doneRows_.store( 0, std::memory_order_relaxed );
+        job->ticket_.store( (static_cast<uint64_t>( line ) << 32) | (line + 1), std::memory_order_release );
+        while( job->doneRows_.load( std::memory_order_acquire ) < width - line - 1 )
+        {
+            if( claimRows( *job ) == t_claim::idle )
+                std::this_thread::yield();
+        }
+    }
+    job->ticket_.store( static_cast<uint64_t>( width - 1 ) << 32, std::memory_order_release );
+
+    // Helpers still queued would only find the job finished
+    std::lock_guard<std::mutex> lock( mutex_ );
+    helpers_.erase( std::remove( helpers_.begin(), helpers_.end(), job ), helpers_.end() );
+}
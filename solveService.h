@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#ifndef __SOLVE_SERVICE__
+#define __SOLVE_SERVICE__
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "boostSimd.h"
+
+struct SolveStats
+{
+    size_t requests_;       // solved since the service started
+    size_t batches_;        // batched kernel runs, each solving up to getBatchLanes() systems per group
+    size_t splits_;         // systems eliminated by several workers together
+    double queueSeconds_;   // sum of the times from submit to a worker picking the request up
+    double maxQueueSeconds_;
+};
+
+// In process solver with a persistent pool, for many request threads. Systems
+// up to batchWidth are taken from the queue together with the other waiting
+// ones of the same width and solved interleaved by batchedSimdTransform; from
+// splitWidth on, the idle workers join the elimination of a system row block
+// by row block; everything in between is solved by simdTransform on one worker.
+class SolveService
+{
+public:
+    SolveService( size_t threads = std::thread::hardware_concurrency(), size_t batchWidth = 32, size_t splitWidth = 512 );
+    ~SolveService();
+
+    SolveService( const SolveService& ) = delete;
+    SolveService& operator=( const SolveService& ) = delete;
+
+    // Row major matrix, rows of matrix.size() / factor.size() values; the future
+    // holds the solution. Requests still queued are solved before destruction.
+    std::future<t_dataVector> submit( t_dataVector matrix, t_dataVector factor );
+
+    SolveStats getStats() const;
+
+    // For the verification: the owner of a split system waits that long after
+    // handing it to the helpers, so they reach it first. Set before submitting.
+    void setSplitDelay( std::chrono::milliseconds delay );
+
+private:
+    struct Request;
+    struct SplitJob;
+
+    void work();
+    void solve( std::vector<std::unique_ptr<Request>>& requests );
+    void solveBatch( std::vector<std::unique_ptr<Request>>& requests );
+    void solveSplit( Request& request );
+
+    size_t batchWidth_;
+    size_t splitWidth_;
+    size_t maxBatch_;
+    std::chrono::milliseconds splitDelay_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::unique_ptr<Request>> queue_;
+    std::deque<std::shared_ptr<SplitJob>> helpers_;
+    bool stop_;
+    SolveStats stats_;
+    std::vector<std::thread> workers_;
+};
+
+#endif // __SOLVE_SERVICE__
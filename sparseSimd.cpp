@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#include <algorithm>
+
+#include <boost/simd/pack.hpp>
+#include <boost/simd/function/any.hpp>
+#include <boost/simd/function/fma.hpp>
+#include <boost/simd/function/aligned_load.hpp>
+#include <boost/simd/function/aligned_store.hpp>
+
+#include "boostSimd.h"
+
+namespace bs = boost::simd;
+
+template< typename T >
+void getBandwidth( const t_vector<T>& matrix, size_t width, size_t& lower, size_t& upper )
+{
+    size_t stride = matrix.size() / width;
+    lower = 0;
+    upper = 0;
+    for( size_t y = 0; y < width; ++y )
+    {
+        const T* pLine = &( matrix[ getIndex( 0, y, stride ) ] );
+        for( size_t x = 0; x < y - lower; ++x )
+        {
+            if( pLine[ x ] != 0 )
+            {
+                lower = y - x;
+                break;
+            }
+        }
+        for( size_t x = width; x-- > y + upper + 1; )
+        {
+            if( pLine[ x ] != 0 )
+            {
+                upper = x - y;
+                break;
+            }
+        }
+    }
+}
+
+// Room for the band, the alignment of the row start and the pack the last
+// update of a row rounds up to
+template< typename T >
+size_t getBandStride( size_t lower, size_t upper )
+{
+	using t_pack = bs::pack<T>;
+
+    size_t stride = lower + upper + 2 * t_pack::static_size;
+    return( (stride + t_pack::static_size - 1) & ~(static_cast<size_t>(t_pack::static_size - 1)) );
+}
+
+template< typename T >
+size_t getBandOffset( size_t y, size_t lower )
+{
+	using t_pack = bs::pack<T>;
+
+    return( y > lower ? (y - lower) & ~(static_cast<size_t>(t_pack::static_size - 1)) : 0 );
+}
+
+template< typename T >
+void toBand( const t_vector<T>& matrix, t_vector<T>& band, size_t width, size_t lower, size_t upper )
+{
+    size_t stride = matrix.size() / width;
+    size_t bandStride = getBandStride<T>( lower, upper );
+    band.assign( width * bandStride, T( 0 ) );
+    for( size_t y = 0; y < width; ++y )
+    {
+        size_t offset = getBandOffset<T>( y, lower );
+        size_t end = std::min( width, offset + bandStride );
+        std::copy( &matrix[ getIndex( offset, y, stride ) ], &matrix[ getIndex( 0, y, stride ) ] + end,
+                   &band[ getIndex( 0, y, bandStride ) ] );
+    }
+}
+
+template< typename T >
+void fromBand( const t_vector<T>& band, t_vector<T>& matrix, size_t width, size_t lower, size_t upper )
+{
+    size_t stride = matrix.size() / width;
+    size_t bandStride = getBandStride<T>( lower, upper );
+    for( size_t y = 0; y < width; ++y )
+    {
+        size_t offset = getBandOffset<T>( y, lower );
+        size_t end = std::min( width, offset + bandStride );
+        T* pLine = &( matrix[ getIndex( 0, y, stride ) ] );
+        std::fill( pLine, pLine + offset, T( 0 ) );
+        std::copy_n( &band[ getIndex( 0, y, bandStride ) ], end - offset, pLine + offset );
+        std::fill( pLine + end, pLine + width, T( 0 ) );
+    }
+}
+
+// Same steps as simdTransform, limited to the lower rows under the pivot and
+// the packs holding the upper columns right of it
+template< typename T >
+void bandedSimdTransform( t_vector<T>& band, t_vector<T>& factor, size_t lower, size_t upper )
+{
+	using t_pack = bs::pack<T>;
+
+	size_t width = factor.size();
+    size_t bandStride = getBandStride<T>( lower, upper );
+	for( size_t line = 0; line < width - 1; ++line )
+	{
+        size_t normLine = line & ~(static_cast<size_t>(t_pack::static_size - 1));
+        size_t lastLine = std::min( width, line + lower + 1 );
+        size_t count = std::min( line + upper + 1, width ) - normLine;
+        const T* pBase = &( band[ getIndex( normLine - getBandOffset<T>( line, lower ), line, bandStride ) ] );
+        T pivot = pBase[ line - normLine ];
+		for( size_t y = line + 1; y < lastLine; ++y )
+		{
+            T* pLine = &( band[ getIndex( normLine - getBandOffset<T>( y, lower ), y, bandStride ) ] );
+            T scale = pLine[ line - normLine ] / pivot;
+            factor[ y ] = bs::fma( -scale, factor[ line ], factor[ y ] );
+
+            t_pack packScale( -scale );
+            for( size_t x = 0; x < count; x += t_pack::static_size )
+			{
+                bs::aligned_store( bs::fma( packScale, bs::aligned_load<t_pack>( pBase + x ), bs::aligned_load<t_pack>( pLine + x ) ), pLine + x );
+			}
+		}
+	}
+}
+
+template< typename T >
+void bandedBackSubstitution( const t_vector<T>& band, t_vector<T>& factor, size_t lower, size_t upper )
+{
+    size_t width = factor.size();
+    size_t bandStride = getBandStride<T>( lower, upper );
+    for( size_t y = width; y-- > 0; )
+    {
+        const T* pLine = &( band[ getIndex( 0, y, bandStride ) ] ) - getBandOffset<T>( y, lower );
+        T sum = factor[ y ];
+        for( size_t x = y + 1; x < std::min( width, y + upper + 1 ); ++x )
+        {
+            sum -= pLine[ x ] * factor[ x ];
+        }
+        factor[ y ] = sum / pLine[ y ];
+    }
+}
+
+// The packs of the pivot row left of the diagonal are zero once the rows above
+// are eliminated, past it they are checked once per pivot and only the nonzero
+// ones are applied, to the rows with a nonzero multiplier
+template< typename T >
+void sparseSimdTransform( t_vector<T>& matrix, t_vector<T>& factor )
+{
+	using t_pack = bs::pack<T>;
+
+	size_t width = factor.size();
+	size_t stride = matrix.size() / width;
+    if( stride % t_pack::static_size )
+    {
+        unalignedSimdTransform( matrix, factor );
+        return;
+    }
+    t_indexVector packs;
+    packs.reserve( stride / t_pack::static_size );
+	for( size_t line = 0; line < width - 1; ++line )
+	{
+        size_t normLine = line & ~(static_cast<size_t>(t_pack::static_size - 1));
+        const T* pBase = &( matrix[ getIndex( 0, line, stride ) ] );
+        packs.clear();
+        for( size_t x = normLine; x < width; x += t_pack::static_size )
+        {
+            if( bs::any( bs::aligned_load<t_pack>( pBase + x ) ) )
+                packs.push_back( x );
+        }
+
+		for( size_t y = line + 1; y < width; ++y )
+		{
+            T* pLine = &( matrix[ getIndex( 0, y, stride ) ] );
+            if( pLine[ line ] == 0 )
+                continue;
+
+            T scale = pLine[ line ] / pBase[ line ];
+            factor[ y ] = bs::fma( -scale, factor[ line ], factor[ y ] );
+
+            t_pack packScale( -scale );
+            for( size_t x : packs )
+			{
+                bs::aligned_store( bs::fma( packScale, bs::aligned_load<t_pack>( pBase + x ), bs::aligned_load<t_pack>( pLine + x ) ), pLine + x );
+			}
+		}
+	}
+}
+
+#define INSTANTIATE_SPARSE( T ) \
+template void getBandwidth( const t_vector<T>& matrix, size_t width, size_t& lower, size_t& upper ); \
+template size_t getBandStride<T>( size_t lower, size_t upper ); \
+template size_t getBandOffset<T>( size_t y, size_t lower ); \
+template void toBand( const t_vector<T>& matrix, t_vector<T>& band, size_t width, size_t lower, size_t upper ); \
+template void fromBand( const t_vector<T>& band, t_vector<T>& matrix, size_t width, size_t lower, size_t upper ); \
+template void bandedSimdTransform( t_vector<T>& band, t_vector<T>& factor, size_t lower, size_t upper ); \
+template void bandedBackSubstitution( const t_vector<T>& band, t_vector<T>& factor, size_t lower, size_t upper ); \
+template void sparseSimdTransform( t_vector<T>& matrix, t_vector<T>& factor );
+
+INSTANTIATE_SPARSE( float )
+INSTANTIATE_SPARSE( double )
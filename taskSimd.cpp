@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2014 Andr Tupinamb (andrelrt@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+//-----------------------------------------------------------------------------
+#include <algorithm>
+
+#include <boost/simd/pack.hpp>
+#include <boost/simd/function/fma.hpp>
+#include <boost/simd/function/load.hpp>
+#include <boost/simd/function/store.hpp>
+
+#include "boostSimd.h"
+
+#ifdef BUILD_TASK_TRANSFORMS
+namespace bs = boost::simd;
+
+namespace
+{
+template< typename T >
+struct Tile
+{
+    using t_pack = bs::pack<T>;
+
+    T* data_;
+    size_t width_;  // row stride of the whole matrix
+    size_t rows_;
+    size_t columns_;
+
+    T& operator()( size_t x, size_t y ) const { return data_[ getIndex( x, y, width_ ) ]; }
+    t_pack loadPack( size_t x, size_t y ) const { return bs::load<t_pack>( &(*this)( x, y ) ); }
+    void storePack( const t_pack& pack, size_t x, size_t y ) const { bs::store( pack, &(*this)( x, y ) ); }
+};
+
+template< typename T >
+Tile<T> getTile( t_vector<T>& matrix, size_t width, size_t tileSize, size_t tileX, size_t tileY )
+{
+    size_t stride = matrix.size() / width;
+    size_t x = tileX * tileSize;
+    size_t y = tileY * tileSize;
+    return( Tile<T>{ &matrix[ getIndex( x, y, stride ) ], stride,
+                  std::min( tileSize, width - y ), std::min( tileSize, width - x ) } );
+}
+
+// line -= scale * base from column x on. Loads are unaligned, as x and the
+// stride are arbitrary, and the columns past the last whole pack are scalar.
+template< typename T >
+void fmaTileRow( const Tile<T>& tile, size_t line, size_t base, T scale, size_t x )
+{
+    using t_pack = bs::pack<T>;
+
+    t_pack packScale( -scale );
+    for( ; x + t_pack::static_size <= tile.columns_; x += t_pack::static_size )
+    {
+        tile.storePack( bs::fma( packScale, tile.loadPack( x, base ), tile.loadPack( x, line ) ), x, line );
+    }
+
+    for( ; x < tile.columns_; ++x )
+    {
+        tile( x, line ) -= scale * tile( x, base );
+    }
+}
+
+// Diagonal tile: unpivoted LU in place, unit L below U
+template< typename T >
+void factorTile( const Tile<T>& diagonal )
+{
+    for( size_t line = 0; line < diagonal.rows_; ++line )
+    {
+        for( size_t y = line + 1; y < diagonal.rows_; ++y )
+        {
+            T scale = diagonal( line, y ) / diagonal( line, line );
+            diagonal( line, y ) = scale;
+            fmaTileRow( diagonal, y, line, scale, line + 1 );
+        }
+    }
+}
+
+// Tile to the right of the diagonal: A = L^-1 A
+template< typename T >
+void solveRowTile( const Tile<T>& diagonal, const Tile<T>& tile )
+{
+    for( size_t line = 0; line < diagonal.rows_; ++line )
+    {
+        for( size_t y = line + 1; y < diagonal.rows_; ++y )
+        {
+            fmaTileRow( tile, y, line, diagonal( line, y ), 0 );
+        }
+    }
+}
+
+// Tile below the diagonal: A = A U^-1, leaving the multipliers
+template< typename T >
+void solveColumnTile( const Tile<T>& diagonal, const Tile<T>& tile )
+{
+    for( size_t y = 0; y < tile.rows_; ++y )
+    {
+        for( size_t line = 0; line < diagonal.columns_; ++line )
+        {
+            T scale = tile( line, y ) / diagonal( line, line );
+            tile( line, y ) = scale;
+            for( size_t x = line + 1; x < diagonal.columns_; ++x )
+            {
+                tile( x, y ) -= scale * diagonal( x, line );
+            }
+        }
+    }
+}
+
+// Trailing tile: A -= L * U, four packs of each row kept in registers
+template< typename T >
+void updateTile( const Tile<T>& left, const Tile<T>& top, const Tile<T>& tile )
+{
+    using t_pack = bs::pack<T>;
+
+    for( size_t y = 0; y < tile.rows_; ++y )
+    {
+        size_t x = 0;
+        const size_t P = t_pack::static_size;
+        while( x + 4 * P <= tile.columns_ )
+        {
+            t_pack acc0 = tile.loadPack( x, y );
+            t_pack acc1 = tile.loadPack( x + P, y );
+            t_pack acc2 = tile.loadPack( x + 2 * P, y );
+            t_pack acc3 = tile.loadPack( x + 3 * P, y );
+            for( size_t k = 0; k < left.columns_; ++k )
+            {
+                t_pack packScale( -left( k, y ) );
+                acc0 = bs::fma( packScale, top.loadPack( x, k ), acc0 );
+                acc1 = bs::fma( packScale, top.loadPack( x + P, k ), acc1 );
+                acc2 = bs::fma( packScale, top.loadPack( x + 2 * P, k ), acc2 );
+                acc3 = bs::fma( packScale, top.loadPack( x + 3 * P, k ), acc3 );
+            }
+            tile.storePack( acc0, x, y );
+            tile.storePack( acc1, x + P, y );
+            tile.storePack( acc2, x + 2 * P, y );
+            tile.storePack( acc3, x + 3 * P, y );
+
+            x += 4 * P;
+        }
+
+        while( x + P <= tile.columns_ )
+        {
+            t_pack acc = tile.loadPack( x, y );
+            for( size_t k = 0; k < left.columns_; ++k )
+            {
+                acc = bs::fma( t_pack( -left( k, y ) ), top.loadPack( x, k ), acc );
+            }
+            tile.storePack( acc, x, y );
+
+            x += P;
+        }
+
+        for( ; x < tile.columns_; ++x )
+        {
+            T acc = tile( x, y );
+            for( size_t k = 0; k < left.columns_; ++k )
+            {
+                acc -= left( k, y ) * top( x, k );
+            }
+            tile( x, y ) = acc;
+        }
+    }
+}
+} // namespace
+
+template< typename T >
+void taskOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor )
+{
+    taskOpenMPTransform( matrix, factor, 128 );
+}
+
+// Tiled elimination driven by task dependencies instead of one parallel for per
+// pivot line. Tile updates of step k + 1 start as soon as the tiles they read
+// are done, so there is no global barrier between steps.
+template< typename T >
+void taskOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor, size_t tileSize )
+{
+    using t_pack = bs::pack<T>;
+
+	size_t width = factor.size();
+    tileSize = (tileSize + t_pack::static_size - 1) & ~(static_cast<size_t>(t_pack::static_size - 1));
+    size_t tiles = (width + tileSize - 1) / tileSize;
+
+    // Only the addresses are used, as task dependency tokens
+    std::vector<char> tokens( tiles * tiles );
+
+#pragma omp parallel
+#pragma omp single
+    for( size_t k = 0; k < tiles; ++k )
+    {
+        Tile<T> diagonal = getTile( matrix, width, tileSize, k, k );
+
+#pragma omp task depend( inout: tokens.data()[ getIndex( k, k, tiles ) ] )
+        factorTile( diagonal );
+
+        for( size_t j = k + 1; j < tiles; ++j )
+        {
+            Tile<T> tile = getTile( matrix, width, tileSize, j, k );
+#pragma omp task depend( in: tokens.data()[ getIndex( k, k, tiles ) ] ) depend( inout: tokens.data()[ getIndex( j, k, tiles ) ] )
+            solveRowTile( diagonal, tile );
+        }
+
+        for( size_t i = k + 1; i < tiles; ++i )
+        {
+            Tile<T> tile = getTile( matrix, width, tileSize, k, i );
+#pragma omp task depend( in: tokens.data()[ getIndex( k, k, tiles ) ] ) depend( inout: tokens.data()[ getIndex( k, i, tiles ) ] )
+            solveColumnTile( diagonal, tile );
+        }
+
+        for( size_t i = k + 1; i < tiles; ++i )
+        {
+            for( size_t j = k + 1; j < tiles; ++j )
+            {
+                Tile<T> left = getTile( matrix, width, tileSize, k, i );
+                Tile<T> top = getTile( matrix, width, tileSize, j, k );
+                Tile<T> tile = getTile( matrix, width, tileSize, j, i );
+#pragma omp task depend( in: tokens.data()[ getIndex( k, i, tiles ) ], tokens.data()[ getIndex( j, k, tiles ) ] ) depend( inout: tokens.data()[ getIndex( j, i, tiles ) ] )
+                updateTile( left, top, tile );
+            }
+        }
+    }
+
+    // Apply L to the factor and clear it, leaving the same upper triangular
+    // form as the other transforms
+    size_t stride = matrix.size() / width;
+    for( size_t y = 1; y < width; ++y )
+    {
+        T* pLine = &( matrix[ getIndex( 0, y, stride ) ] );
+        T sum = 0;
+        for( size_t x = 0; x < y; ++x )
+        {
+            sum += pLine[ x ] * factor[ x ];
+            pLine[ x ] = 0;
+        }
+        factor[ y ] -= sum;
+    }
+}
+
+#define INSTANTIATE_TASK_TRANSFORMS( T ) \
+template void taskOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor ); \
+template void taskOpenMPTransform( t_vector<T>& matrix, t_vector<T>& factor, size_t tileSize );
+
+INSTANTIATE_TASK_TRANSFORMS( float )
+INSTANTIATE_TASK_TRANSFORMS( double )
+#endif // BUILD_TASK_TRANSFORMS